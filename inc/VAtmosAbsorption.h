@@ -25,13 +25,17 @@
 #include <map>
 #include <string>
 #include <sstream>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 
 #include "TMath.h"
 #include "TRandom3.h"
 
+#include "atmcache.h"
+
 // #include "TCanvas.h"  // only needed for visualisation
 // #include "TGraph.h"   // only needed for visualisation
 // #include "TH1D.h" // only needed for visualisation
@@ -65,6 +69,9 @@ class VAtmosAbsorption
         void   read_extint( int );                        //!< read kascade atmospheric extinction file (kextint.dat)
         void   read_extint_F2( int );                        //!< read kascade atmospheric extinction file (kextint.dat)
         void   read_extint_M5( );                         //!< read henrikes atmospheric extinction file (modtran 5)
+        void   readExtinctionTables( int iLambdaMin = 0 );   //!< read extinction tables (from binary cache if available)
+        bool   readCache( string iTag );                  //!< restore extinction tables from binary cache
+        void   writeCache( string iTag );                 //!< write extinction tables to binary cache
         
     public:
         VAtmosAbsorption( string, int, string iSourceFile = "" );
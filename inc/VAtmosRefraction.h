@@ -0,0 +1,63 @@
+//! VAtmosRefraction  refraction correction of Cherenkov photon bunches
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VATMOSREFRACTION_H
+#define VATMOSREFRACTION_H
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "atmo.h"
+#include "mc_tel.h"
+
+using namespace std;
+
+class VAtmosRefraction
+{
+    private:
+        bool   fInitialized;
+
+        double fObservationLevel;        //!< observation level [cm]
+        double fZemMax;                  //!< highest tabulated emission height [cm]
+        double fSinMax;                  //!< largest tabulated sine of emission zenith angle
+
+        int    fNZem;                    //!< number of emission heights
+        int    fNSin;                    //!< number of emission zenith angles
+        double fZemStep;                 //!< step in emission height [cm]
+        double fSinStep;                 //!< step in sine of emission zenith angle
+
+        vector< float > fHoriOff;        //!< horizontal displacement along the photon azimuth [cm]
+        vector< float > fTimeOff;        //!< travel time w.r.t. straight line [ns]
+        vector< float > fSinRatio;       //!< sin(observed zenith) / sin(emission zenith)
+
+    public:
+        VAtmosRefraction( int iNZem = 500, int iNSin = 100 );
+        ~VAtmosRefraction() {}
+        bool   correctBunch( bunch& b, double& dt );
+        void   fillTables( double iObservationLevel, double iZemMax = 60.e5, double iZenithMax_deg = 80. );
+        bool   isInitialized()
+        {
+            return fInitialized;
+        }
+};
+
+#endif
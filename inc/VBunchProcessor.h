@@ -0,0 +1,110 @@
+//! VBunchProcessor  photon bunches of one telescope to detected photons
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VBUNCHPROCESSOR_H
+#define VBUNCHPROCESSOR_H
+
+#include <cmath>
+#include <vector>
+
+#include "TRandom3.h"
+
+#include "initial.h"
+#include "io_basic.h"
+#include "mc_tel.h"
+
+#include "VAtmosAbsorption.h"
+#include "VAtmosRefraction.h"
+#include "VExpectedYield.h"
+#include "VIOHistograms.h"
+#include "VRunStatistics.h"
+#include "VTrigger.h"
+
+using namespace std;
+
+class VBunchProcessor
+{
+    private:
+        VAtmosAbsorption* fAtmos;
+        TRandom3* fRandom;
+        double fQueff;                       //!< global quantum efficiency
+        double fWavelengthMin;               //!< wavelength interval of the 1/lambda^2 spectrum [nm]
+        double fWavelengthMax;
+        double fAirLightSpeed;               //!< speed of light at observation level [cm/ns]
+
+        VAtmosRefraction* fRefraction;       //!< refraction correction (optional)
+        VIOHistograms* fHisto;               //!< histograms (optional)
+        VTrigger* fTrigger;                  //!< trigger emulation (optional)
+        bool bTriggerTwoPass;
+        VRunStatistics* fStats;              //!< timers and counters (optional)
+        VExpectedYield* fExpected;           //!< expected photon yields instead of the photon loop (optional)
+        bool bWeightedBunches;               //!< one weighted record per bunch (with fExpected)
+        double fWeightMin;                   //!< bunches below this weight are merged (deterministic Russian roulette)
+
+        // result of the last telescope
+        vector< bunch > fSurvived;
+        vector< double > fSurvivedProb;
+        double fExpectedPhotons;
+
+        // expected wavelength spectra (counts-only mode)
+        vector< double > fExpectedLambda;
+        vector< double > fExpectedGenerated;
+        vector< double > fExpectedDetected;
+
+    public:
+        VBunchProcessor( VAtmosAbsorption* iAtmos, TRandom3* iRandom, double iQueff = 1. );
+        ~VBunchProcessor() {}
+        void endArray();
+        double getExpectedPhotons() const
+        {
+            return fExpectedPhotons;
+        }
+        vector< bunch >& getSurvived()
+        {
+            return fSurvived;
+        }
+        int processTelescope( bunch* iBunches, int iNBunches, const telescope_array& iArray, int iTel, bool iOutput = true );
+        void setAirLightSpeed( double iSpeed )
+        {
+            fAirLightSpeed = iSpeed;
+        }
+        void setExpectedYield( VExpectedYield* iExpected, bool iWeightedBunches = false, double iWeightMin = 0. );
+        void setHistograms( VIOHistograms* iHisto )
+        {
+            fHisto = iHisto;
+        }
+        void setRefraction( VAtmosRefraction* iRefraction )
+        {
+            fRefraction = iRefraction;
+        }
+        void setStatistics( VRunStatistics* iStats )
+        {
+            fStats = iStats;
+        }
+        void setTrigger( VTrigger* iTrigger, bool iTwoPass = false )
+        {
+            fTrigger = iTrigger;
+            bTriggerTwoPass = iTwoPass;
+        }
+        void setWavelengthRange( double iMin, double iMax );
+};
+
+#endif
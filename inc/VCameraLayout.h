@@ -0,0 +1,78 @@
+//! VCameraLayout  focal plane pixelization of Cherenkov photon directions
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VCAMERALAYOUT_H
+#define VCAMERALAYOUT_H
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class VCameraLayout
+{
+    private:
+        int    fNPixX;                   //!< number of pixels in x
+        int    fNPixY;                   //!< number of pixels in y
+        double fPixelSize_deg;           //!< pixel size [deg]
+        double fTanPixelSize;            //!< pixel size in the tangential plane
+
+        // telescope pointing (index: CORSIKA telescope number, starting at 0)
+        // axis: travel direction of on-axis photons; e1, e2: focal plane axes
+        vector< double > fPointingZe_deg;
+        vector< double > fPointingAz_deg;
+        vector< vector< double > > fAxis;
+        vector< vector< double > > fE1;
+        vector< vector< double > > fE2;
+
+        void   setPointing( unsigned int iTel, double ze_deg, double az_deg );
+
+    public:
+        VCameraLayout();
+        ~VCameraLayout() {}
+        int    getNPixels() const
+        {
+            return fNPixX * fNPixY;
+        }
+        int    getNPixelsX() const
+        {
+            return fNPixX;
+        }
+        int    getNPixelsY() const
+        {
+            return fNPixY;
+        }
+        double getPixelSize() const
+        {
+            return fPixelSize_deg;
+        }
+        int    getPixel( int iTel, double cx, double cy ) const;
+        void   print() const;
+        bool   readLayout( string iFile );
+        void   setCamera( int iNPixX, int iNPixY, double iPixelSize_deg );
+};
+
+#endif
@@ -0,0 +1,149 @@
+//! VEventProcessor  processing of the blocks of a CORSIKA eventio file (headers, telescope arrays, output)
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VEVENTPROCESSOR_H
+#define VEVENTPROCESSOR_H
+
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TRandom3.h"
+
+#include "initial.h"
+#include "io_basic.h"
+#include "mc_tel.h"
+#include "atmo.h"
+
+#include "VAtmosAbsorption.h"
+#include "VAtmosRefraction.h"
+#include "VBunchProcessor.h"
+#include "VCORSIKARunheader.h"
+#include "VEventReader.h"
+#include "VExpectedYield.h"
+#include "VGrisu.h"
+#include "VIOHistograms.h"
+#include "VProgressReporter.h"
+#include "VRunStatistics.h"
+#include "VTraceWriter.h"
+#include "VTrigger.h"
+
+using namespace std;
+
+class VEventProcessor
+{
+    private:
+        VEventReader* fReader;
+        TRandom3* fRandom;
+        TRandom3 fRandomEvent;               //!< random generator state at the beginning of an array (two-pass trigger)
+        VAtmosAbsorption* fAtmos;
+        VBunchProcessor* fBunchProcessor;
+        VExpectedYield* fExpected;           //!< expected photon yields instead of the photon loop (optional)
+        bool bWeightedBunches;               //!< one weighted record per bunch in the grisu output (with fExpected)
+        double fQueff;                       //!< global quantum efficiency
+
+        // photon output in grisu format
+        string fVersion;
+        bool bGRISU;
+        string fGrisuOutputFile;
+        int fAtmID;                          //!< atmosphere for corsika event number and depth in grisu output (-printmoreinfo)
+        bool bPrintMoreInfo;
+        vector< VGrisu* > fGrisu;
+        // histograms and tree (optional)
+        VIOHistograms* fHisto;
+        // corsika run header class
+        VCORSIKARunheader* fRunHeader;
+
+        // telescope and array selection
+        int fNTel;                           //!< telescope to be processed (-1: all, one output file; -2: one file per telescope)
+        int fNArray;                         //!< number of arrays per event to be read (<0: all)
+        int fNArrayRead;
+        string fGrisuConfigurationFile;
+        vector< int > fTelescopeMatrix;      //!< corsika to grisudet telescope numbering
+
+        // trigger emulation (optional)
+        VTrigger* fTrigger;
+        bool bTriggerTwoPass;
+
+        // atmosphere
+        bool bAtmProfile;
+        bool bRefraction;
+        VAtmosRefraction fRefraction;
+        bool bCEFFICWarning;
+
+        // stage timers and counters, timeline (optional)
+        VRunStatistics* fStats;
+        VTraceWriter* fTrace;
+        // progress reports (optional)
+        VProgressReporter* fProgress;
+        double fPhotonsProcessed;            //!< photons of all processed telescopes (output pass)
+
+        void initGrisu();
+        void processArray();
+        void readEventHeader();
+        void readRunHeader();
+        vector< int > readTelescopeMatrix( string iCFGFile, int ntel, double* xtel, double* ytel );
+        void writePhotons( int iTel, vector< bunch >& iPhotons );
+
+    public:
+        VEventProcessor( VEventReader* iReader, VAtmosAbsorption* iAtmos, TRandom3* iRandom, double iQueff = 1., string iVersion = "" );
+        ~VEventProcessor();
+        VCORSIKARunheader* getRunHeader()
+        {
+            return fRunHeader;
+        }
+        double getPhotonsProcessed() const
+        {
+            return fPhotonsProcessed;
+        }
+        void processBlock( int iType );
+        void setArraySelection( int iNArray )
+        {
+            fNArray = iNArray;
+        }
+        void setExpectedYield( VExpectedYield* iExpected, bool iWeightedBunches = false, double iWeightMin = 0. );
+        void setGrisuOutput( string iFile );
+        void setHistograms( VIOHistograms* iHisto );
+        void setPrintMoreInfo( int iAtmID );
+        void setProgress( VProgressReporter* iProgress )
+        {
+            fProgress = iProgress;
+        }
+        void setRefraction( bool iRefraction = true )
+        {
+            bRefraction = iRefraction;
+        }
+        void setStatistics( VRunStatistics* iStats );
+        void setTelescopeSelection( int iTel, string iGrisuConfigurationFile = "" )
+        {
+            fNTel = iTel;
+            fGrisuConfigurationFile = iGrisuConfigurationFile;
+        }
+        void setTrigger( VTrigger* iTrigger, bool iTwoPass = false );
+        void terminate( bool iPrint = true );
+};
+
+#endif
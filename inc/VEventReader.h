@@ -0,0 +1,175 @@
+//! VEventReader  streaming reader for CORSIKA eventio files
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VEVENTREADER_H
+#define VEVENTREADER_H
+
+#include "initial.h"
+#include "io_basic.h"
+#include "mc_tel.h"
+#include "sim_cors.h"
+#include "VRunStatistics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+class VEventReader
+{
+    private:
+        IO_BUFFER* iobuf;
+        IO_ITEM_HEADER fBlockHeader;
+        IO_ITEM_HEADER fItemHeader;       //!< current telescope array
+        IO_ITEM_HEADER fSubItemHeader;    //!< current telescope
+        string fFileName;
+
+        bool bDebug;
+        bool bPrintHeaders;
+        VRunStatistics* fStats;           //!< stage timers and counters (optional)
+
+        // CORSIKA run and event headers/trailers
+        real runh[273];
+        real rune[273];
+        real evth[273];
+        real evte[273];
+        struct linked_string fInputs;
+
+        telescope_array* fArray;
+        double fAltitude;                 //!< shower direction [deg]
+        double fAzimuth;
+        double fAirLightSpeed;            //!< speed of light at observation level [cm/ns]
+        int fNEvent;                      //!< number of events read (event trailers)
+        long long fBytesRead;             //!< bytes of all blocks read
+        long long fFileSize;              //!< size of input file (0: unknown)
+
+        // photon bunches of the current telescope (decode buffer)
+        bunch* fBunches;
+        int fMaxBunches;
+        int fNBunches;
+        double fPhotons;
+        int fTelescopeID;
+        int fArrayID;
+        int fNTelescopesRead;             //!< telescopes read in current array
+
+        void readRunHeader();
+        void readEventHeader();
+        void freeInputLines();
+
+    public:
+        VEventReader( int iMaxBunches = 50000000 );
+        ~VEventReader();
+        bool open( string iFile );
+        void close();
+        int  next();
+        bool beginArray();
+        int  nextTelescope();
+        bool rewindArray();
+        void endArray();
+
+        double getAirLightSpeed() const
+        {
+            return fAirLightSpeed;
+        }
+        double getAltitude() const
+        {
+            return fAltitude;
+        }
+        double getAzimuth() const
+        {
+            return fAzimuth;
+        }
+        telescope_array& getArray()
+        {
+            return *fArray;
+        }
+        int getArrayID() const
+        {
+            return fArrayID;
+        }
+        bunch* getBunches()
+        {
+            return fBunches;
+        }
+        long long getBytesRead() const
+        {
+            return fBytesRead;
+        }
+        real* getEventEnd()
+        {
+            return evte;
+        }
+        real* getEventHeader()
+        {
+            return evth;
+        }
+        long long getFileSize() const
+        {
+            return fFileSize;
+        }
+        IO_BUFFER* getIOBuffer()
+        {
+            return iobuf;
+        }
+        int getNBunches() const
+        {
+            return fNBunches;
+        }
+        int getNEvents() const
+        {
+            return fNEvent;
+        }
+        double getPhotons() const
+        {
+            return fPhotons;
+        }
+        real* getRunEnd()
+        {
+            return rune;
+        }
+        real* getRunHeader()
+        {
+            return runh;
+        }
+        int getTelescopeID() const
+        {
+            return fTelescopeID;
+        }
+        void setDebug( bool iDebug = true )
+        {
+            bDebug = iDebug;
+        }
+        void setPrintHeaders( bool iPrint = true )
+        {
+            bPrintHeaders = iPrint;
+        }
+        void setStatistics( VRunStatistics* iStats )
+        {
+            fStats = iStats;
+        }
+};
+
+#endif
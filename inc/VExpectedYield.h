@@ -0,0 +1,76 @@
+//! VExpectedYield  expected number of detected photons per bunch (counts-only mode)
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VEXPECTEDYIELD_H
+#define VEXPECTEDYIELD_H
+
+#include <iostream>
+#include <vector>
+
+#include "VAtmosAbsorption.h"
+
+using namespace std;
+
+class VExpectedYield
+{
+    private:
+        VAtmosAbsorption* fAtmos;
+        double fQueff;                   //!< global quantum efficiency
+        double fBinWidth;                //!< width of the wavelength integration steps [nm]
+
+        // wavelength integration (1/lambda^2 spectrum)
+        double fWavelengthMin;           //!< [nm]
+        double fWavelengthMax;           //!< [nm]
+        vector< double > fLambda;        //!< wavelength of integration steps [nm]
+        vector< double > fWeight;        //!< fraction of the 1/lambda^2 spectrum per step
+
+        // table of efficiencies in emission height [m] and direction cosine
+        double fHeightStep;
+        int    fNHeight;
+        double fCosMin;
+        double fCosStep;
+        int    fNCos;
+        vector< double > fEfficiency;    //!< efficiency per table node and wavelength step
+        vector< double > fMeanEfficiency;    //!< integrated efficiency per table node
+
+        // spectra (generated photons per table node, outside the table per wavelength step)
+        double fGenerated;
+        vector< double > fNodePhotons;
+        vector< int > fNodeFilled;
+        vector< double > fDirectDetected;
+
+        void fillTable();
+
+    public:
+        VExpectedYield( VAtmosAbsorption* iAtmos, double iQueff = 1., double iBinWidth = 2. );
+        ~VExpectedYield() {}
+        double addBunch( double iPhotons, double iZem, double iCosZ );
+        void clearTable();
+        double getEfficiency( double iLambda, double iZem, double iCosZ );
+        double getIntegratedEfficiency( double iZem, double iCosZ );
+        static double getLensTransmission( double iLambda );
+        static double getQuantumEfficiency( double iLambda );
+        void getSpectrum( vector< double >& iLambda, vector< double >& iGenerated, vector< double >& iDetected );
+        void resetSpectrum();
+        void setWavelengthRange( double iMin, double iMax );
+};
+
+#endif
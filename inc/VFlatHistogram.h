@@ -0,0 +1,137 @@
+//! VFlatHistogram  fixed-bin histogram accumulator
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VFLATHISTOGRAM_H
+#define VFLATHISTOGRAM_H
+
+#include "TH1.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+class VFlatHistogram
+{
+    private:
+        int    fNx;
+        int    fNy;                  //!< 0 for 1D histograms
+        double fXmin;
+        double fXmax;
+        double fYmin;
+        double fYmax;
+        double fXscale;              //!< bins per unit x
+        double fYscale;              //!< bins per unit y
+
+        vector< double > fBins;      //!< bin contents incl. under/overflow (ROOT global bin numbering)
+        vector< char > fTouched;     //!< bin has been filled since last reset
+        vector< int > fFilledBins;   //!< filled global bins (in order of first fill)
+        TH1*  fCopyTarget;           //!< histogram written by the last copyTo()
+        vector< int > fCopiedBins;   //!< bins written by the last copyTo()
+
+        double fEntries;
+        double fStats[7];            //!< sumw, sumw2, sumwx, sumwx2, sumwy, sumwy2, sumwxy (ROOT convention)
+
+        /*! ROOT bin number along one axis (0: underflow, n+1: overflow) */
+        inline int findBin( double x, int n, double xmin, double xmax, double scale ) const
+        {
+            if( x < xmin )
+            {
+                return 0;
+            }
+            if( !( x < xmax ) )
+            {
+                return n + 1;
+            }
+            int b = 1 + ( int )( ( x - xmin ) * scale );
+            return ( b > n ? n : b );
+        }
+
+        inline void addToBin( int ibin, double w )
+        {
+            if( !fTouched[ibin] )
+            {
+                fTouched[ibin] = 1;
+                fFilledBins.push_back( ibin );
+            }
+            fBins[ibin] += w;
+        }
+
+    public:
+        VFlatHistogram( int nx, double xmin, double xmax, int ny = 0, double ymin = 0., double ymax = 1. );
+        ~VFlatHistogram() {}
+
+        /*! fill 1D histogram */
+        inline void fill( double x, double w = 1. )
+        {
+            int bx = findBin( x, fNx, fXmin, fXmax, fXscale );
+            addToBin( bx, w );
+            fEntries++;
+            if( bx > 0 && bx <= fNx )
+            {
+                fStats[0] += w;
+                fStats[1] += w * w;
+                fStats[2] += w * x;
+                fStats[3] += w * x * x;
+            }
+        }
+        /*! fill 2D histogram */
+        inline void fill2D( double x, double y, double w = 1. )
+        {
+            int bx = findBin( x, fNx, fXmin, fXmax, fXscale );
+            int by = findBin( y, fNy, fYmin, fYmax, fYscale );
+            addToBin( bx + ( fNx + 2 ) * by, w );
+            fEntries++;
+            if( bx > 0 && bx <= fNx && by > 0 && by <= fNy )
+            {
+                fStats[0] += w;
+                fStats[1] += w * w;
+                fStats[2] += w * x;
+                fStats[3] += w * x * x;
+                fStats[4] += w * y;
+                fStats[5] += w * y * y;
+                fStats[6] += w * x * y;
+            }
+        }
+        void   add( const VFlatHistogram& h );
+        void   fillN( int n, const double* x, const double* w = 0 );
+        void   fillN2D( int n, const double* x, const double* y, const double* w = 0 );
+        void   copyTo( TH1* h );
+        double getEntries() const
+        {
+            return fEntries;
+        }
+        int    getNbinsX() const
+        {
+            return fNx;
+        }
+        double getXmax() const
+        {
+            return fXmax;
+        }
+        double getXmin() const
+        {
+            return fXmin;
+        }
+        void   reset();
+};
+
+#endif
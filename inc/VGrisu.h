@@ -27,6 +27,7 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <string>
 
 #include "VCORSIKARunheader.h"
@@ -43,6 +44,9 @@ class VGrisu
     private:
         bool bSTDOUT;                        //!< write output to stdout
         ofstream of_file;                    //!< output file
+        bool bBufferEvent;                   //!< keep event output in fEventBuffer until commitEvent()
+        ostringstream fEventBuffer;          //!< output of current event
+        bool bWeightedBunches;               //!< write weighted bunches ("B" lines) instead of photons
         map<int, int> particles;             //!< particle ID transformation matrix: first: CORSIKA ID, second: kascade ID
         float degrad;                        //!< convertion deg->rad
         int primID;                          //!< primary particle ID
@@ -56,14 +60,26 @@ class VGrisu
         
         string fVersion;
         
+        ostream& getEventStream();
+        void writePhotonLine( ostream& os, const bunch& i_bunch, int i_tel );
         void transformCoord( float&, float&, float& );     //!< transform from CORSIKA to GrIsu coordinates
         void makeParticleMap();              //!< make map with  particle ID transformation matrix
         float redang( float );             //! reduce large angle to intervall 0, 2*pi
         
     public:
         VGrisu( string fVersion = "", int id = -1 );
-        ~VGrisu() {}
+        ~VGrisu();
+        void commitEvent();                  //!< write buffered event to output file
+        void discardEvent();                 //!< drop buffered event
+        void setEventBuffering( bool iB = true )
+        {
+            bBufferEvent = iB;
+        }
         void setOutputfile( string );       //!< create grisu readable output file
+        void setWeightedBunches( bool iB = true )
+        {
+            bWeightedBunches = iB;    //!< write "B" lines with bunch weight (in bunch.photons)
+        }
         void setObservationHeight( double ih )
         {
             observation_height = ih;    //!< set observation height
@@ -77,8 +93,9 @@ class VGrisu
             qeff = iq;    //!< set global quantum efficiency
         }
         void writeRunHeader( float*, VCORSIKARunheader* );      //!<  write some information about CORSIKA run intot the runheader
-        void writeEvent( telescope_array, bool );  //!< write MC information
-        void writePhotons( bunch, int );         //!< write next photon to grisu file ("P" line)
+        void writeEvent( const telescope_array&, bool );  //!< write MC information
+        void writePhotons( const bunch&, int );  //!< write next photon to grisu file ("P" line)
+        void writePhotonsN( int n, const bunch* ph, int i_tel );  //!< write n photons ("P" lines)
 };
 
 #endif
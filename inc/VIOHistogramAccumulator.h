@@ -0,0 +1,132 @@
+//! VIOHistogramAccumulator  per-worker accumulator for VIOHistograms
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VIOHISTOGRAMACCUMULATOR_H
+#define VIOHISTOGRAMACCUMULATOR_H
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "mc_tel.h"
+#include "VCameraLayout.h"
+#include "VFlatHistogram.h"
+
+using namespace std;
+
+class VIOHistogramAccumulator
+{
+    friend class VIOHistograms;
+
+    private:
+        bool bFillHistograms;        // false for short histogram output (tree only)
+        bool bCORSIKA_coordinates;   // fill photons in corsika coordinates
+        bool bFillPhotons;           // fill photon directions, pixels and 2D histograms (false: summary output only)
+
+        VFlatHistogram* fT0;
+        VFlatHistogram* fZem;
+        VFlatHistogram* fGLambda;
+        VFlatHistogram* fGProb;
+        VFlatHistogram* fGZem;
+        VFlatHistogram* fSXY;
+        VFlatHistogram* fSLambda;
+        VFlatHistogram* fSProb;
+        VFlatHistogram* fSZem;
+        vector< VFlatHistogram* > fCXYZ;
+        vector< double > fXYZlevelsHeight;
+        // xyz levels sorted by decreasing height
+        vector< double > fXYZsortedHeight;
+        vector< VFlatHistogram* > fXYZsortedHisto;
+        vector< double > fXYZxp;     // projected photon positions (scratch)
+        vector< double > fXYZyp;
+
+        vector< double > fNCp;       // number of photons per telescope
+        vector< double > fCX;
+        vector< double > fCY;
+        vector< int > fTelID;
+        
+        // focal plane pixelization (replaces fCX, fCY, fTelID)
+        const VCameraLayout* fCamera;
+        vector< int > fPixelCounts;  // index: telescope * pixels + pixel
+        vector< int > fPixelFilled;  // filled indices of fPixelCounts
+        
+        // arrival time histograms per pixel (key: (telescope * pixels + pixel) * time bins + time bin)
+        double fTimeBinWidth;        // [ns] (<=0: no time binning)
+        double fTimeMin;             // [ns]
+        int    fNTimeBins;
+        unordered_map< long long, int > fTimeCounts;
+        
+        // photon arrival times (telescope coincidences)
+        bool bArrivalTimes;
+        vector< int > fArrivalTel;
+        vector< float > fArrivalTime;
+        
+        void addPixel( unsigned int iIndex, int iCounts );
+
+        // position in the sequence of commits (see setOrder())
+        int fEvent;
+        int fPart;
+
+        // not implemented (histograms are owned by the accumulator)
+        VIOHistogramAccumulator& operator=( const VIOHistogramAccumulator& );
+
+        void initHistograms( int xybin, double xmax, double ymax, double zemax );
+        void initXYZhistograms( vector< double > iXYZlevelsHeight, int xybin, double xmax, double ymax );
+        void sortXYZlevels();
+
+    public:
+        VIOHistogramAccumulator( bool iFillHistograms, bool iCORSIKA_coordinates );
+        VIOHistogramAccumulator( const VIOHistogramAccumulator& iAcc );
+        ~VIOHistogramAccumulator();
+        void add( const VIOHistogramAccumulator& iAcc );
+        void fillBunch( const bunch&, double );
+        void fillExpected( double iZem, double iLambda, double iGenerated, double iDetected );
+        void fillGenerated( const bunch&, double );
+        void fillNPhotons( int iTel, double iphotons );
+        void fillSurvived( const bunch&, double, int );
+        void reset();
+        void setOrder( int iEvent, int iPart )
+        {
+            fEvent = iEvent;
+            fPart = iPart;
+        }
+        void setCameraLayout( const VCameraLayout* iCamera )
+        {
+            fCamera = iCamera;
+        }
+        void setFillPhotons( bool iB = true )
+        {
+            bFillPhotons = iB;
+        }
+        void setArrivalTimes( bool iB = true )
+        {
+            bArrivalTimes = iB;
+        }
+        void setTimeBinning( double iWidth, double iTMin, int iNBins )
+        {
+            fTimeBinWidth = iWidth;
+            fTimeMin = iTMin;
+            fNTimeBins = iNBins;
+        }
+};
+
+#endif
@@ -27,10 +27,14 @@
 #include "TH2D.h"
 #include "TList.h"
 #include "TClonesArray.h"
+#include "Compression.h"
 #include "TMath.h"
 #include "TTree.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -38,6 +42,8 @@
 
 #include "mc_tel.h"
 #include "sim_cors.h"
+#include "VIOHistogramAccumulator.h"
+#include "VTelescopeCoincidence.h"
 
 using namespace std;
 
@@ -65,14 +71,26 @@ class VIOHistograms
         
         TClonesArray* hCXYZ;
         
+        // run-level sums of the per-event 1D histograms (written in terminate())
+        vector< VFlatHistogram* > fRunSum;
+        vector< TH1D* > hRun;
+        
+        // accumulator for the current event (copied into histograms and tree for each tree entry)
+        VIOHistogramAccumulator* fEventAcc;
+        
         TFile* fout;
         TTree* fTree;
+        TTree* fPhotonTree;          // photon level branches (fTree, separate tree, or none)
+        bool bSplitTrees;            // summary tree without photon level branches
+        bool bWritePhotonTree;       // separate photon tree (split trees)
         
         vector< double > fXYZlevelsHeight;
         vector< double > fXYZlevelsThickness;
 
         
         int nevent;
+        int fNextPart;               // next part of the current event to be committed
+        bool bEventPending;          // current event is written to the tree with the next newEvent() or terminate()
         double degrad;
         
         // event block
@@ -121,6 +139,35 @@ class VIOHistograms
         std::vector <double > CY;  //NK
         //std::vector <double > CTime; //NK
         std::vector <int > telID; //NK
+        // reduced precision photon branches (see setPhotonPrecision())
+        int fPhotonPrecision;
+        vector< float > CXf;
+        vector< float > CYf;
+        vector< short > CXs;         // cx * 30000 (as compact_bunch)
+        vector< short > CYs;
+        vector< short > telIDs;
+        double CXYscale;
+        
+        // focal plane pixelization (replaces CX, CY, telID)
+        VCameraLayout* fCamera;
+        vector< int > pixTelID;
+        vector< int > pixID;
+        vector< int > pixNPhotons;
+        // photon arrival time histograms per pixel (sparse: only filled time bins)
+        double timeBinWidth;
+        double timeBinMin;
+        int    timeBinNumber;
+        vector< int > ptTelID;
+        vector< int > ptPixID;
+        vector< int > ptTimeBin;
+        vector< int > ptNPhotons;
+        // photon arrival time coincidences between telescopes
+        VTelescopeCoincidence* fCoincidence;
+        double coincWindow;
+        int    coincMultiplicity;
+        vector< int > coincTelA;
+        vector< int > coincTelB;
+        vector< double > coincNPairs;
 
         double toff;
         bool bShort;
@@ -128,8 +175,17 @@ class VIOHistograms
         bool bCORSIKA_coordinates;   // fill photons in corsika coordinates
         
         bool bSmallFile; // reduce output
+        
+        // ROOT output settings (-1 / 0: ROOT defaults)
+        int fCompressionAlgorithm;
+        int fCompressionLevel;
+        int fBasketSize;             // buffer size of histogram and vector branches [bytes]
+        Long64_t fAutoFlush;         // >0: entries, <0: bytes
         bool bMuon;      // adjust histograms for muon input
         
+        void fillTrees();
+        void initRunHistograms();
+        void flushHistograms();
         double redang( double );
         void transformCoord( double&, double&, double& );
         
@@ -137,15 +193,49 @@ class VIOHistograms
         VIOHistograms();
         ~VIOHistograms() {}
         void init( string, bool );
-        void newEvent( float*, telescope_array, int );
+        void discardEvent();
+        void newEvent( float*, const telescope_array&, int );
         void initXYZhistograms();
-        void fillBunch( bunch, double );
-        void fillGenerated( bunch, double );
+        void fillBunch( const bunch&, double );
+        void fillExpected( double iZem, double iLambda, double iGenerated, double iDetected );
+        void fillGenerated( const bunch&, double );
         void fillNPhotons( int iTel, double iphotons );
-        void fillSurvived( bunch, double, float*, int );
+        void fillSurvived( const bunch&, double, float*, int );
+        void fillSurvivedN( int n, const bunch* ph, const double* prob, int iTel );
+        VIOHistogramAccumulator* newAccumulator();
+        bool commit( VIOHistogramAccumulator* iAcc );
+        int getEventIndex() const    // index of the current event (counts all newEvent() calls; -1: no event)
+        {
+            return nevent - 1;
+        }
+        void setCameraLayout( VCameraLayout* iCamera )
+        {
+            fCamera = iCamera;
+        }
+        void setAutoFlush( Long64_t iAutoFlush )
+        {
+            fAutoFlush = iAutoFlush;
+        }
+        void setBasketSize( int iBasketSize )
+        {
+            fBasketSize = iBasketSize;
+        }
+        void setCoincidenceWindow( double iWindow );
+        bool setCompression( string iSetting );
+        bool setPhotonPrecision( string iPrecision );
+        void setSplitTrees( bool iWritePhotonTree )
+        {
+            bSplitTrees = true;
+            bWritePhotonTree = iWritePhotonTree;
+        }
+        void setTimeBinning( double iWidth, double iTMin, double iTMax );
         void setCORSIKAcoordinates()
         {
             bCORSIKA_coordinates = true;
+            if( fEventAcc )
+            {
+                fEventAcc->bCORSIKA_coordinates = true;
+            }
         }
         void set_small_file()
         {
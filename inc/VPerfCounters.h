@@ -0,0 +1,69 @@
+//! VPerfCounters  hardware performance counters (Linux perf_event_open)
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VPERFCOUNTERS_H
+#define VPERFCOUNTERS_H
+
+#include <string>
+
+using namespace std;
+
+class VPerfCounters
+{
+    public:
+        enum E_COUNTER
+        {
+            CYCLES = 0,
+            INSTRUCTIONS,
+            CACHE_MISSES,
+            BRANCH_MISSES,
+            N_COUNTERS
+        };
+
+    private:
+        int fGroupFD;                        //!< group leader (first counter opened)
+        int fFD[N_COUNTERS];
+        int fIndex[N_COUNTERS];              //!< position in group read (-1: counter not available)
+        int fNOpen;
+        string fStatus;
+
+    public:
+        VPerfCounters();
+        ~VPerfCounters();
+        bool open();
+        void close();
+        static const char* getCounterName( int iCounter );
+        string getStatus() const
+        {
+            return fStatus;
+        }
+        bool isAvailable() const
+        {
+            return ( fNOpen > 0 );
+        }
+        bool isAvailable( int iCounter ) const
+        {
+            return ( iCounter >= 0 && iCounter < N_COUNTERS && fIndex[iCounter] >= 0 );
+        }
+        bool read( double* iValues );
+};
+
+#endif
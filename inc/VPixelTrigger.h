@@ -0,0 +1,62 @@
+//! VPixelTrigger  pixel threshold trigger in a coincidence window
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VPIXELTRIGGER_H
+#define VPIXELTRIGGER_H
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "VCameraLayout.h"
+#include "VTrigger.h"
+
+using namespace std;
+
+class VPixelTrigger : public VTrigger
+{
+    private:
+        const VCameraLayout* fCamera;
+        int    fThreshold;               //!< photons per pixel
+        double fWindow;                  //!< coincidence window [ns]
+        int    fMinTelescopes;           //!< minimum number of triggered telescopes
+
+        // photons of the current event: (telescope * pixels + pixel, arrival time [ns])
+        vector< pair< long long, double > > fPhotons;
+        vector< int > fTriggeredTel;
+
+    protected:
+        bool isTriggered();
+
+    public:
+        VPixelTrigger( const VCameraLayout* iCamera, int iThreshold, double iWindow, int iMinTelescopes = 1 );
+        ~VPixelTrigger() {}
+        void fill( int iTel, const bunch& ph );
+        const vector< int >& getTriggeredTelescopes() const
+        {
+            return fTriggeredTel;
+        }
+        void print() const;
+        void reset();
+};
+
+#endif
@@ -0,0 +1,74 @@
+//! VProgressReporter  periodic progress and throughput report of a run
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VPROGRESSREPORTER_H
+#define VPROGRESSREPORTER_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <pthread.h>
+
+using namespace std;
+
+class VProgressReporter
+{
+    private:
+        double fInterval;                //!< time between reports [s]
+        string fStatusFile;              //!< status file (empty: report to stderr)
+        string fInputFile;
+        long long fTotalBytes;           //!< size of input file (0: unknown)
+        int fEventLimit;                 //!< maximum number of events to be read (<=0: no limit)
+        double fStartTime;
+
+        // progress (updated by the main thread)
+        long long fBytes;
+        int fEvents;
+        double fPhotons;
+
+        // previous report (rates over the last interval)
+        double fLastTime;
+        long long fLastBytes;
+        int fLastEvents;
+        double fLastPhotons;
+
+        pthread_t fThread;
+        pthread_mutex_t fMutex;
+        pthread_cond_t fCondition;
+        bool bRunning;
+        bool bStop;
+
+        static void* run( void* iReporter );
+        void report( bool iFinal );
+        static string formatBytes( double iBytes );
+        static string formatTime( double iSeconds );
+
+    public:
+        VProgressReporter( double iInterval, string iStatusFile = "" );
+        ~VProgressReporter();
+        void setInput( string iInputFile, long long iTotalBytes, int iEventLimit = -1 );
+        bool start();
+        void stop();
+        void update( long long iBytes, int iEvents, double iPhotons );
+};
+
+#endif
@@ -0,0 +1,219 @@
+//! VRunStatistics  per-stage timers and counters of the main loop
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VRUNSTATISTICS_H
+#define VRUNSTATISTICS_H
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <time.h>
+
+#include "VPerfCounters.h"
+#include "VTraceWriter.h"
+
+using namespace std;
+
+class VRunStatistics
+{
+    public:
+        enum E_STAGE
+        {
+            BLOCK_FIND = 0,
+            BLOCK_READ,
+            PHOTON_DECODE,
+            PHOTON_LOOP,                      //!< contains extinction, QE/lens and per-photon histogram filling
+            EXTINCTION,
+            QE_LENS,
+            HISTOGRAM_FILL,
+            GRISU_WRITE,
+            ROOT_WRITE,
+            N_STAGES
+        };
+
+    private:
+        double fStartTime;
+        double fTimerOverhead;                //!< time of one clock reading [s] (subtracted from each measurement)
+        double fStageTime[N_STAGES];          //!< [s]
+        long long fStageCalls[N_STAGES];
+        int fPhotonSampling;                  //!< per-photon stages are timed for every n-th photon
+        long long fPhotonCounter;
+
+        map< int, long long > fBlocks;        //!< blocks per type
+        map< int, long long > fBlockBytes;
+        long long fBytes;
+        long long fBunches;
+        double fPhotonsGenerated;
+        double fPhotonsSurviving;        //!< expected number in counts-only mode
+        long long fTelescopesRead;
+        long long fTelescopesSkipped;
+
+        VTraceWriter* fTrace;                 //!< timeline of stages (optional)
+        VPerfCounters* fPerf;                 //!< hardware counters per stage (optional)
+        double fStageCounters[N_STAGES][VPerfCounters::N_COUNTERS];
+        long long fStageCounterCalls[N_STAGES];   //!< timer calls with hardware counters
+        string fPerfStatus;                   //!< availability of hardware counters (empty: not requested)
+
+    public:
+        VRunStatistics( int iPhotonSampling = 16 );
+        ~VRunStatistics() {}
+
+        static double now()
+        {
+            struct timespec ts;
+            clock_gettime( CLOCK_MONOTONIC, &ts );
+            return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+        }
+        static string escapeJSON( const string& iString );
+        static string getBlockName( int iType );
+        static const char* getStageName( int iStage );
+
+        void addTime( int iStage, double iStart, double iSeconds, double iWeight = 1., bool iTrace = false )
+        {
+            if( iSeconds > fTimerOverhead )
+            {
+                fStageTime[iStage] += ( iSeconds - fTimerOverhead ) * iWeight;
+            }
+            fStageCalls[iStage]++;
+            if( iTrace && fTrace )
+            {
+                fTrace->complete( getStageName( iStage ), "stage", iStart, iSeconds );
+            }
+        }
+        void addCounters( int iStage, const double* iStart, const double* iStop, double iWeight = 1. )
+        {
+            for( int i = 0; i < VPerfCounters::N_COUNTERS; i++ )
+            {
+                fStageCounters[iStage][i] += ( iStop[i] - iStart[i] ) * iWeight;
+            }
+            fStageCounterCalls[iStage]++;
+        }
+        void countBlock( int iType, long long iBytes );
+        void countBunches( int iBunches )
+        {
+            fBunches += iBunches;
+        }
+        void countPhotons( double iGenerated, double iSurviving )
+        {
+            fPhotonsGenerated += iGenerated;
+            fPhotonsSurviving += iSurviving;
+        }
+        void countTelescope( bool iSkipped )
+        {
+            if( iSkipped )
+            {
+                fTelescopesSkipped++;
+            }
+            else
+            {
+                fTelescopesRead++;
+            }
+        }
+        long long getBytes() const
+        {
+            return fBytes;
+        }
+        VPerfCounters* getPerfCounters()
+        {
+            return fPerf;
+        }
+        int getPhotonSampling() const
+        {
+            return fPhotonSampling;
+        }
+        VTraceWriter* getTrace()
+        {
+            return fTrace;
+        }
+        bool samplePhoton()
+        {
+            return ( ++fPhotonCounter % fPhotonSampling ) == 0;
+        }
+        void setPerfCounters( VPerfCounters* iPerf )
+        {
+            fPerf = ( iPerf && iPerf->isAvailable() ? iPerf : 0 );
+            fPerfStatus = ( iPerf ? iPerf->getStatus() : "" );
+        }
+        void setTrace( VTraceWriter* iTrace )
+        {
+            fTrace = iTrace;
+        }
+        bool writeJSON( string iFile, string iInputFile );
+};
+
+/*!
+    timer for one stage: time between construction and stop() (or destruction)
+
+    No-op if no statistics object is given. With iTrace, each call is
+    written as a span into the trace (if any; not for per-bunch or
+    per-photon timers). With iCounters, hardware counters (if any) are
+    read at start and stop; per-bunch and per-photon timers are timed
+    only, as reading the counters (system calls) would disturb the
+    counts of the enclosing photon loop stage.
+*/
+class VStageTimer
+{
+    private:
+        VRunStatistics* fStats;
+        int fStage;
+        double fWeight;
+        bool bTrace;
+        bool bCounters;
+        double fStart;
+        double fCounterStart[VPerfCounters::N_COUNTERS];
+
+    public:
+        VStageTimer( VRunStatistics* iStats, int iStage, double iWeight = 1., bool iTrace = true, bool iCounters = true )
+        {
+            fStats = iStats;
+            fStage = iStage;
+            fWeight = iWeight;
+            bTrace = iTrace;
+            bCounters = ( iCounters && fStats && fStats->getPerfCounters() );
+            if( bCounters )
+            {
+                fStats->getPerfCounters()->read( fCounterStart );
+            }
+            fStart = ( fStats ? VRunStatistics::now() : 0. );
+        }
+        ~VStageTimer()
+        {
+            stop();
+        }
+        void stop()
+        {
+            if( fStats )
+            {
+                fStats->addTime( fStage, fStart, VRunStatistics::now() - fStart, fWeight, bTrace );
+                if( bCounters )
+                {
+                    double iCounterStop[VPerfCounters::N_COUNTERS];
+                    fStats->getPerfCounters()->read( iCounterStop );
+                    fStats->addCounters( fStage, fCounterStart, iCounterStop, fWeight );
+                }
+                fStats = 0;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,84 @@
+//! VTelescopeCoincidence  photon arrival time coincidences between telescopes
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VTELESCOPECOINCIDENCE_H
+#define VTELESCOPECOINCIDENCE_H
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+class VTelescopeCoincidence
+{
+    private:
+        double fWindow;                          //!< coincidence window [ns]
+
+        // photons of the current event: (sortable arrival time << 16) | telescope
+        vector< unsigned long long > fKeys;
+        vector< unsigned long long > fScratch;
+        // time sorted arrival times per telescope
+        vector< vector< float > > fStream;
+        vector< int > fTelCounts;
+
+        // results
+        vector< int > fTelA;
+        vector< int > fTelB;
+        vector< double > fNPairs;
+        int fMultiplicity;
+
+        void radixSort();
+        static unsigned int timeKey( float t );
+        static float keyTime( unsigned int k );
+
+    public:
+        VTelescopeCoincidence( double iWindow = 0. );
+        ~VTelescopeCoincidence() {}
+        void clear();
+        void evaluate();
+        void fill( int iTel, float t );
+        int  getMultiplicity() const
+        {
+            return fMultiplicity;
+        }
+        const vector< double >& getNPairs() const
+        {
+            return fNPairs;
+        }
+        const vector< int >& getTelA() const
+        {
+            return fTelA;
+        }
+        const vector< int >& getTelB() const
+        {
+            return fTelB;
+        }
+        double getWindow() const
+        {
+            return fWindow;
+        }
+        void setWindow( double iWindow )
+        {
+            fWindow = iWindow;
+        }
+};
+
+#endif
@@ -0,0 +1,84 @@
+//! VTraceWriter  timeline of the processing pipeline in Chrome trace-event format
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VTRACEWRITER_H
+#define VTRACEWRITER_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class VTraceWriter
+{
+    private:
+        FILE* fFile;
+        string fFileName;
+        double fStartTime;                    //!< time of first event (trace time 0)
+        long long fNTraceEvents;
+        vector< string > fOpenSpans;          //!< spans started with begin()
+
+        void writeEvent( const string& iName, const string& iCategory, char iPhase, double iTime, double iDuration, const string& iArgs );
+
+    public:
+        VTraceWriter();
+        ~VTraceWriter();
+        bool open( string iFile, string iProcessName = "corsikaIOreader" );
+        void close();
+        void begin( string iName, string iCategory, string iArgs = "" );
+        void end( string iArgs = "" );
+        void complete( string iName, string iCategory, double iStart, double iDuration, string iArgs = "" );
+        long long getNTraceEvents() const
+        {
+            return fNTraceEvents;
+        }
+        bool isOpen() const
+        {
+            return ( fFile != 0 );
+        }
+};
+
+/*!
+    span between construction and destruction
+
+    No-op if no (open) trace writer is given.
+*/
+class VTraceSpan
+{
+    private:
+        VTraceWriter* fTrace;
+        string fName;
+        string fCategory;
+        string fArgs;
+        double fStart;
+
+    public:
+        VTraceSpan( VTraceWriter* iTrace, string iName, string iCategory );
+        ~VTraceSpan();
+        void setArgs( string iArgs )
+        {
+            fArgs = iArgs;
+        }
+};
+
+#endif
@@ -0,0 +1,82 @@
+//! VTrigger  trigger stage deciding if an event is written to the output
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+*/
+
+#ifndef VTRIGGER_H
+#define VTRIGGER_H
+
+#include <iostream>
+
+#include "mc_tel.h"
+
+using namespace std;
+
+/*
+    base class for trigger emulations
+
+    The reader calls reset() at the beginning of each event (telescope
+    array), fill() for each photon surviving extinction and detector
+    efficiencies, and evaluate() once all photons of the event are
+    filled. Events failing the trigger are not written.
+*/
+class VTrigger
+{
+    private:
+        unsigned int fNEvents;
+        unsigned int fNTriggered;
+
+    protected:
+        virtual bool isTriggered() = 0;
+
+    public:
+        VTrigger()
+        {
+            fNEvents = 0;
+            fNTriggered = 0;
+        }
+        virtual ~VTrigger() {}
+        bool evaluate()
+        {
+            fNEvents++;
+            if( isTriggered() )
+            {
+                fNTriggered++;
+                return true;
+            }
+            return false;
+        }
+        virtual void fill( int iTel, const bunch& ph ) = 0;
+        unsigned int getNEvents() const
+        {
+            return fNEvents;
+        }
+        unsigned int getNTriggered() const
+        {
+            return fNTriggered;
+        }
+        virtual void print() const = 0;
+        void printStatistics() const
+        {
+            cout << "trigger: " << fNTriggered << " of " << fNEvents << " events triggered" << endl;
+        }
+        virtual void reset() = 0;
+};
+
+#endif
@@ -0,0 +1,57 @@
+/* ============================================================================
+
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+============================================================================ */
+
+/** @file atmcache.h
+ *  @short Binary cache for parsed atmospheric tables (atmcache.c).
+ */
+
+#ifndef ATMCACHE_H__LOADED
+#define ATMCACHE_H__LOADED 1
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Increase whenever the layout of any cached payload changes. */
+#define ATMCACHE_VERSION 1
+
+/** A read-only memory mapped cache file. */
+struct atmcache_map
+{
+   void *addr;          /**< Start of the mapping */
+   size_t len;          /**< Length of the mapping */
+   const void *data;    /**< Start of the payload (after the header) */
+   size_t data_len;     /**< Length of the payload */
+};
+
+/* atmcache.c */
+int atmcache_open(const char *src_fname, const char *tag,
+   struct atmcache_map *m);
+void atmcache_close(struct atmcache_map *m);
+int atmcache_write(const char *src_fname, const char *tag,
+   const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
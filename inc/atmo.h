@@ -67,6 +67,10 @@ void atmfit_(int *nlp, double *hlay, double *aatm, double *batm, double *catm);
 
 /* C called functions (parameter types are always checked) */
 double rpol(double *x, double *y, int n, double xp);
+void rhofx_batch(const double *height, double *rho, int n);
+void thickx_batch(const double *height, double *thick, int n);
+void refidx_batch(const double *height, double *n_ref, int n);
+void heighx_batch(const double *thick, double *height, int n);
 
 /* FORTRAN functions called from C */
 /// The CORSIKA built-in density lookup function.
@@ -38,6 +38,7 @@ extern "C" {
 void initpath(const char *default_path);
 void listpath (char *buffer, size_t bufsize);
 void addpath(const char *name);
+int findpath(const char *fname, char *buffer, size_t bufsize);
 FILE *fileopen(const char *fname, const char *mode);
 int fileclose(FILE *f);
 
@@ -89,7 +89,7 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
     if( fModel == "modtran5" )
     {
         fSourceFile = iSourceFile;
-        read_extint_M5( );
+        readExtinctionTables();
     }
     
     else if( fModel == "CORSIKA" || fModel == "corsika" )
@@ -105,7 +105,7 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
             fSourceFile = "data/atmabs.dat";
         }
         
-        readCorsikaAtmabs();
+        readExtinctionTables();
         
     }
     // kascade extinction values
@@ -120,7 +120,7 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
             fSourceFile = "data/kextint.dat";
         }
         // for the original kextint, this should be 180.
-        read_extint( 180 );
+        readExtinctionTables( 180 );
         
     }
     // MODTRAN4 US76 extinction values
@@ -136,7 +136,7 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
         {
             fSourceFile = "data/us76.50km.ext";
         }
-        read_extint( 200 );
+        readExtinctionTables( 200 );
     }
     else if( fModel == "us76.23km" || fModel == "us76.23" || fModel == "modtran4_2" )
     {
@@ -150,7 +150,7 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
         {
             fSourceFile = "data/us76.23km.ext";
         }
-        read_extint_F2( 200 );
+        readExtinctionTables( 200 );
     }
     else if( fModel == "artemis" )
     {
@@ -162,7 +162,7 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
         {
             fSourceFile = "data/extinction_uv.dat";
         }
-        read_extint( 180 );
+        readExtinctionTables( 180 );
     }
     else if( fModel == "noExtinction" )
     {
@@ -176,6 +176,168 @@ VAtmosAbsorption::VAtmosAbsorption( string model, int fSeed, string iSourceFile
     }
 }
 
+/*!
+   read extinction tables of the current model from fSourceFile
+
+   parsed tables are stored in a binary cache (see atmcache.c) and taken
+   from there as long as the source file is unchanged
+
+   \param iLambdaMin minimum wavelength in the extinction file [nm] (kascade/modtran4/artemis)
+*/
+void VAtmosAbsorption::readExtinctionTables( int iLambdaMin )
+{
+    ostringstream iTag;
+    iTag << "extint_" << fModel << "_" << iLambdaMin;
+    
+    if( readCache( iTag.str() ) )
+    {
+        cerr << "VAtmosAbsorption: atmospheric extinction tables from cache (source file " << fSourceFile << ")" << endl;
+        return;
+    }
+    
+    if( fModel == "modtran5" )
+    {
+        read_extint_M5();
+    }
+    else if( fModel == "corsika" )
+    {
+        readCorsikaAtmabs();
+    }
+    else if( fModel == "modtran4_2" )
+    {
+        read_extint_F2( iLambdaMin );
+    }
+    else
+    {
+        read_extint( iLambdaMin );
+    }
+    writeCache( iTag.str() );
+}
+
+/*!
+    restore fCoeff and extint from the binary cache
+
+    payload: number of coefficient vectors, then (wavelength, size, values) for each;
+             number of extinction rows, then (size, values) for each
+*/
+bool VAtmosAbsorption::readCache( string iTag )
+{
+    struct atmcache_map m;
+    if( atmcache_open( fSourceFile.c_str(), iTag.c_str(), &m ) != 0 )
+    {
+        return false;
+    }
+    const char* p = ( const char* )m.data;
+    const char* p_end = p + m.data_len;
+    bool bOK = true;
+    
+    map< int, vector<double> > iCoeff;
+    vector< vector<double> > iExtint;
+    
+    uint32_t n = 0;
+    uint32_t nv = 0;
+    int32_t wl = 0;
+    if( p + sizeof( n ) <= p_end )
+    {
+        memcpy( &n, p, sizeof( n ) );
+        p += sizeof( n );
+    }
+    else
+    {
+        bOK = false;
+    }
+    for( uint32_t i = 0; bOK && i < n; i++ )
+    {
+        if( p + sizeof( wl ) + sizeof( nv ) > p_end )
+        {
+            bOK = false;
+            break;
+        }
+        memcpy( &wl, p, sizeof( wl ) );
+        p += sizeof( wl );
+        memcpy( &nv, p, sizeof( nv ) );
+        p += sizeof( nv );
+        if( ( size_t )( p_end - p ) < nv * sizeof( double ) )
+        {
+            bOK = false;
+            break;
+        }
+        vector< double > v( nv );
+        memcpy( v.data(), p, nv * sizeof( double ) );
+        p += nv * sizeof( double );
+        iCoeff[wl] = v;
+    }
+    if( bOK && p + sizeof( n ) <= p_end )
+    {
+        memcpy( &n, p, sizeof( n ) );
+        p += sizeof( n );
+    }
+    else
+    {
+        bOK = false;
+    }
+    for( uint32_t i = 0; bOK && i < n; i++ )
+    {
+        if( p + sizeof( nv ) > p_end )
+        {
+            bOK = false;
+            break;
+        }
+        memcpy( &nv, p, sizeof( nv ) );
+        p += sizeof( nv );
+        if( ( size_t )( p_end - p ) < nv * sizeof( double ) )
+        {
+            bOK = false;
+            break;
+        }
+        vector< double > v( nv );
+        memcpy( v.data(), p, nv * sizeof( double ) );
+        p += nv * sizeof( double );
+        iExtint.push_back( v );
+    }
+    atmcache_close( &m );
+    
+    if( !bOK || p != p_end )
+    {
+        return false;
+    }
+    fCoeff = iCoeff;
+    extint = iExtint;
+    return true;
+}
+
+/*!
+    write fCoeff and extint to the binary cache (failures are ignored)
+*/
+void VAtmosAbsorption::writeCache( string iTag )
+{
+    vector< char > iData;
+    uint32_t n = 0;
+    uint32_t nv = 0;
+    int32_t wl = 0;
+    
+    n = ( uint32_t )fCoeff.size();
+    iData.insert( iData.end(), ( const char* )&n, ( const char* )&n + sizeof( n ) );
+    map< int, vector<double> >::const_iterator m_iter;
+    for( m_iter = fCoeff.begin(); m_iter != fCoeff.end(); ++m_iter )
+    {
+        wl = m_iter->first;
+        nv = ( uint32_t )m_iter->second.size();
+        iData.insert( iData.end(), ( const char* )&wl, ( const char* )&wl + sizeof( wl ) );
+        iData.insert( iData.end(), ( const char* )&nv, ( const char* )&nv + sizeof( nv ) );
+        iData.insert( iData.end(), ( const char* )m_iter->second.data(), ( const char* )( m_iter->second.data() + nv ) );
+    }
+    n = ( uint32_t )extint.size();
+    iData.insert( iData.end(), ( const char* )&n, ( const char* )&n + sizeof( n ) );
+    for( unsigned int i = 0; i < extint.size(); i++ )
+    {
+        nv = ( uint32_t )extint[i].size();
+        iData.insert( iData.end(), ( const char* )&nv, ( const char* )&nv + sizeof( nv ) );
+        iData.insert( iData.end(), ( const char* )extint[i].data(), ( const char* )( extint[i].data() + nv ) );
+    }
+    atmcache_write( fSourceFile.c_str(), iTag.c_str(), iData.data(), iData.size() );
+}
+
 /*!
    \param obslevel observation level in [m]
 */
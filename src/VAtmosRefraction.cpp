@@ -0,0 +1,185 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VAtmosRefraction
+    \brief refraction correction of Cherenkov photon bunches
+
+    CORSIKA runs without the 'ATMEXT with refraction' option propagate
+    photons on straight lines. This class applies the bending corrections
+    of raybnd_() (atmo.c) to the bunches.
+
+    raybnd_() is evaluated once per atmosphere on a grid of emission height
+    and sine of the emission zenith angle; per bunch the corrections are
+    obtained by bilinear interpolation (no asin() or profile interpolation
+    in the photon loop).
+
+    Tabulated are (all relative to a straight line):
+       - horizontal displacement at observation level along the photon azimuth [cm]
+       - light travel time difference [ns]
+       - ratio sin(observed zenith angle) / sin(emission zenith angle)
+
+    The atmospheric profile (atmset_) must be initialised before fillTables() is called.
+*/
+
+#include "VAtmosRefraction.h"
+
+VAtmosRefraction::VAtmosRefraction( int iNZem, int iNSin )
+{
+    fInitialized = false;
+
+    fObservationLevel = 0.;
+    fZemMax = 0.;
+    fSinMax = 0.;
+
+    fNZem = ( iNZem > 1 ? iNZem : 2 );
+    fNSin = ( iNSin > 1 ? iNSin : 2 );
+    fZemStep = 0.;
+    fSinStep = 0.;
+}
+
+/*!
+    fill refraction tables
+
+    \param iObservationLevel  observation level [cm]
+    \param iZemMax            highest tabulated emission height [cm] (bunches above are corrected as if emitted at this height)
+    \param iZenithMax_deg     largest tabulated emission zenith angle [deg] (bunches beyond are not corrected)
+*/
+void VAtmosRefraction::fillTables( double iObservationLevel, double iZemMax, double iZenithMax_deg )
+{
+    fObservationLevel = iObservationLevel;
+    fZemMax = iZemMax;
+    if( fZemMax <= fObservationLevel )
+    {
+        fZemMax = fObservationLevel + 60.e5;
+    }
+    fSinMax = sin( iZenithMax_deg * M_PI / 180. );
+
+    fZemStep = ( fZemMax - fObservationLevel ) / ( double )( fNZem - 1 );
+    fSinStep = fSinMax / ( double )( fNSin - 1 );
+
+    fHoriOff.assign( fNZem * fNSin, 0. );
+    fTimeOff.assign( fNZem * fNSin, 0. );
+    fSinRatio.assign( fNZem * fNSin, 1. );
+
+    for( int z = 0; z < fNZem; z++ )
+    {
+        double zem = fObservationLevel + z * fZemStep;
+
+        // vertical photon: travel time along straight line
+        cors_real_now_t u = 0.;
+        cors_real_now_t v = 0.;
+        double w = 1.;
+        cors_real_now_t dx = 0.;
+        cors_real_now_t dy = 0.;
+        cors_real_now_t dt_vert = 0.;
+        raybnd_( &zem, &u, &v, &w, &dx, &dy, &dt_vert );
+
+        for( int s = 1; s < fNSin; s++ )
+        {
+            double sin_em = s * fSinStep;
+            double w_em = sqrt( 1. - sin_em * sin_em );
+            u = sin_em;
+            v = 0.;
+            w = w_em;
+            dx = 0.;
+            dy = 0.;
+            cors_real_now_t dt = 0.;
+            raybnd_( &zem, &u, &v, &w, &dx, &dy, &dt );
+            // raybnd_ leaves all values untouched for total reflection
+            if( dt == 0. )
+            {
+                continue;
+            }
+            fHoriOff[z * fNSin + s] = dx;
+            fTimeOff[z * fNSin + s] = dt - dt_vert / w_em;
+            fSinRatio[z * fNSin + s] = u / sin_em;
+        }
+    }
+    fInitialized = true;
+
+    cout << "refraction tables filled (observation level " << fObservationLevel * 0.01 << " m, ";
+    cout << fNZem << " emission heights up to " << fZemMax * 1.e-5 << " km, ";
+    cout << fNSin << " zenith angles up to " << iZenithMax_deg << " deg)" << endl;
+}
+
+/*!
+    apply refraction correction to a photon bunch
+
+    position and direction of the bunch are corrected in place,
+    dt is the additional light travel time [ns]
+
+    returns false if the bunch is outside the tabulated range
+*/
+bool VAtmosRefraction::correctBunch( bunch& b, double& dt )
+{
+    dt = 0.;
+    if( !fInitialized )
+    {
+        return false;
+    }
+    double sin_em = sqrt( ( double )b.cx * b.cx + ( double )b.cy * b.cy );
+    if( sin_em >= fSinMax )
+    {
+        return false;
+    }
+
+    double fz = ( b.zem - fObservationLevel ) / fZemStep;
+    if( fz < 0. )
+    {
+        fz = 0.;
+    }
+    else if( fz > fNZem - 1 )
+    {
+        fz = fNZem - 1;
+    }
+    int iz = ( int )fz;
+    if( iz >= fNZem - 1 )
+    {
+        iz = fNZem - 2;
+    }
+    fz -= iz;
+
+    double fs = sin_em / fSinStep;
+    int is = ( int )fs;
+    if( is >= fNSin - 1 )
+    {
+        is = fNSin - 2;
+    }
+    fs -= is;
+
+    unsigned int i00 = iz * fNSin + is;
+    unsigned int i10 = i00 + fNSin;
+    double w00 = ( 1. - fz ) * ( 1. - fs );
+    double w01 = ( 1. - fz ) * fs;
+    double w10 = fz * ( 1. - fs );
+    double w11 = fz * fs;
+
+    dt = w00 * fTimeOff[i00] + w01 * fTimeOff[i00 + 1] + w10 * fTimeOff[i10] + w11 * fTimeOff[i10 + 1];
+
+    if( sin_em > 0. )
+    {
+        double hori  = w00 * fHoriOff[i00]  + w01 * fHoriOff[i00 + 1]  + w10 * fHoriOff[i10]  + w11 * fHoriOff[i10 + 1];
+        double ratio = w00 * fSinRatio[i00] + w01 * fSinRatio[i00 + 1] + w10 * fSinRatio[i10] + w11 * fSinRatio[i10 + 1];
+
+        b.x += hori * b.cx / sin_em;
+        b.y += hori * b.cy / sin_em;
+        b.cx *= ratio;
+        b.cy *= ratio;
+    }
+    return true;
+}
@@ -0,0 +1,362 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VBunchProcessor
+    \brief photon bunches of one telescope to detected photons
+
+    For each bunch (as read by VEventReader): refraction correction
+    (optional), arrival time at ground, and for each photon in the bunch
+    wavelength (1/lambda^2 spectrum or CORSIKA wavelength), atmospheric
+    extinction, global and PANOSETI quantum efficiency and lens
+    transmission. Surviving photons of the telescope are available with
+    getSurvived() (positions in [m] relative to the array centre) and
+    filled into the trigger and histograms (if set).
+
+    With an expected-yield object (counts-only mode and weighted bunches),
+    the photon loop is replaced by the expected number of detected
+    photons per bunch; with weighted bunches getSurvived() returns one
+    record per bunch with the weight in bunch.photons.
+
+    \section example example
+
+    \code
+    VBunchProcessor fProcessor( &fAtabso, &fRandom, queff );
+    fProcessor.setAirLightSpeed( fReader->getAirLightSpeed() );
+    fProcessor.setWavelengthRange( evth[95], evth[96] );
+    ....
+    while( fReader->nextTelescope() > 0 )
+    {
+        int n = fProcessor.processTelescope( fReader->getBunches(), fReader->getNBunches(),
+                                             fReader->getArray(), fReader->getTelescopeID() );
+        vector< bunch >& ph = fProcessor.getSurvived();
+        ....
+    }
+    \endcode
+*/
+
+#include "VBunchProcessor.h"
+
+VBunchProcessor::VBunchProcessor( VAtmosAbsorption* iAtmos, TRandom3* iRandom, double iQueff )
+{
+    fAtmos = iAtmos;
+    fRandom = iRandom;
+    fQueff = iQueff;
+    fWavelengthMin = 300.;
+    fWavelengthMax = 700.;
+    fAirLightSpeed = 29.9792458 / 1.0002256; /* [cm/ns] at H=2200 m */
+    fRefraction = 0;
+    fHisto = 0;
+    fTrigger = 0;
+    bTriggerTwoPass = false;
+    fStats = 0;
+    fExpected = 0;
+    bWeightedBunches = false;
+    fWeightMin = 0.;
+    fExpectedPhotons = 0.;
+    fSurvived.reserve( 100000 );
+    fSurvivedProb.reserve( 100000 );
+}
+
+/*!
+    expected photon yields instead of the photon loop (counts-only mode);
+    with iWeightedBunches one record per bunch (weights below iWeightMin are merged)
+*/
+void VBunchProcessor::setExpectedYield( VExpectedYield* iExpected, bool iWeightedBunches, double iWeightMin )
+{
+    fExpected = iExpected;
+    bWeightedBunches = ( iExpected && iWeightedBunches );
+    fWeightMin = iWeightMin;
+}
+
+/*!
+    wavelength interval of the 1/lambda^2 Cherenkov spectrum [nm] (from the CORSIKA event header)
+*/
+void VBunchProcessor::setWavelengthRange( double iMin, double iMax )
+{
+    fWavelengthMin = iMin;
+    fWavelengthMax = iMax;
+    if( fExpected )
+    {
+        fExpected->setWavelengthRange( iMin, iMax );
+    }
+}
+
+/*!
+    process the photon bunches of telescope iTel
+
+    \param iOutput  false: first pass of the two-pass trigger (fills the trigger only)
+
+    \return number of surviving photons (weighted bunch records)
+*/
+int VBunchProcessor::processTelescope( bunch* iBunches, int iNBunches, const telescope_array& iArray, int iTel, bool iOutput )
+{
+    fSurvived.clear();
+    fSurvivedProb.clear();
+    fExpectedPhotons = 0.;
+    bool bFillTrigger = ( fTrigger && ( !iOutput || !bTriggerTwoPass ) );
+    bunch Chphoton;
+    double lambda;
+    double prob;
+    double refraction_dt;
+
+    VStageTimer iPhotonLoopTimer( fStats, VRunStatistics::PHOTON_LOOP );
+    // (start with half the threshold: merged weight is rounded instead of truncated)
+    double fWeightSum = 0.5 * fWeightMin;
+    for( int ibunch = 0; ibunch < iNBunches; ibunch++ ) // loop over all bunches for this telescope
+    {
+        double wl_bunch = iBunches[ibunch].lambda;
+        // refraction: corrected position, direction and additional travel time
+        refraction_dt = 0.;
+        if( fRefraction )
+        {
+            fRefraction->correctBunch( iBunches[ibunch], refraction_dt );
+        }
+        double cx = iBunches[ibunch].cx;
+        double cy = iBunches[ibunch].cy;
+        double cz = -1.*sqrt( 1. - cx * cx - cy * cy ); /* direction is downwards */
+        /* Use secans(zenith angle) for airmass, */
+        /* i.e. assume a plane atmosphere. */
+        double airmass = 1.e16;
+        if( cz != 0. )
+        {
+            airmass = -1. / cz;
+        }
+        /* Distance between CORSIKA observation level and */
+        /* telescope fixed position. */
+        double tel_dist = iArray.ztel[iTel] * airmass;
+        /* Note that, although tracing starts at the CORSIKA */
+        /* level, the bunch time corresponds to the crossing */
+        /* of the telescope level. */
+        double tel_delay = tel_dist / fAirLightSpeed;
+        /* Note also that the photon bunch might be created */
+        /* behind the telescope mirror. Check in raytracing. */
+
+        // (GM) restore arrival time at ground:
+        // add travel time from telescope plane to ground plane
+        double corstime = iBunches[ibunch].ctime + tel_delay + refraction_dt;
+
+        // fill all bunch specific stuff into histograms
+        if( fHisto && iOutput )
+        {
+            VStageTimer iTimer( fStats, VRunStatistics::HISTOGRAM_FILL, 1., false, false );
+            fHisto->fillBunch( iBunches[ibunch], corstime );
+        }
+        if( fStats && iOutput )
+        {
+            fStats->countPhotons( iBunches[ibunch].photons, 0. );
+        }
+        // counts-only mode and weighted bunches: expected number of detected photons instead of the photon loop
+        if( fExpected )
+        {
+            double iZem = iBunches[ibunch].zem * 0.01;
+            double iDetected = 0.;
+            if( wl_bunch >= 1000. )
+            {
+                continue;
+            }
+            else if( wl_bunch > 0. )
+            {
+                // wavelength generated in CORSIKA
+                iDetected = iBunches[ibunch].photons * fExpected->getEfficiency( wl_bunch, iZem, -1. * cz );
+            }
+            else
+            {
+                // (wavelength spectra are filled at the end of the array)
+                iDetected = fExpected->addBunch( iBunches[ibunch].photons, iZem, -1. * cz );
+            }
+            if( fHisto )
+            {
+                fHisto->fillExpected( iZem, ( wl_bunch > 0. ? wl_bunch : 0. ), iBunches[ibunch].photons, iDetected );
+            }
+            fExpectedPhotons += iDetected;
+            if( !bWeightedBunches || iDetected <= 0. )
+            {
+                continue;
+            }
+            // deterministic Russian roulette: bunches below the threshold are accumulated,
+            // a record of weight fWeightMin is written whenever the sum exceeds the threshold
+            double iWeight = iDetected;
+            if( iDetected < fWeightMin )
+            {
+                fWeightSum += iDetected;
+                if( fWeightSum < fWeightMin )
+                {
+                    continue;
+                }
+                fWeightSum -= fWeightMin;
+                iWeight = fWeightMin;
+            }
+            Chphoton.photons = iWeight;
+            Chphoton.x = iBunches[ibunch].x * 0.01 + iArray.xtel[iTel] * 0.01;
+            Chphoton.y = iBunches[ibunch].y * 0.01 + iArray.ytel[iTel] * 0.01;
+            Chphoton.cx = iBunches[ibunch].cx;
+            Chphoton.cy = iBunches[ibunch].cy;
+            Chphoton.ctime = corstime;
+            Chphoton.zem = iZem;
+            Chphoton.lambda = ( wl_bunch > 0. ? wl_bunch : 0. );
+            fSurvived.push_back( Chphoton );
+            continue;
+        }
+        // now loop over bunch
+        for( ; iBunches[ibunch].photons > 0; iBunches[ibunch].photons -= 1. )
+        {
+            // per-photon stages are timed for a sample of photons only
+            VRunStatistics* iPhotonStats = ( fStats && fStats->samplePhoton() ? fStats : 0 );
+            double iPhotonWeight = ( iPhotonStats ? iPhotonStats->getPhotonSampling() : 0. );
+            VStageTimer iExtinctionTimer( iPhotonStats, VRunStatistics::EXTINCTION, iPhotonWeight, false, false );
+            // photon wavelength
+            if( wl_bunch <= 0. )
+            {
+                /* get photon wavelength according to 1./lambda^2 distribution */
+                /* (wl_bunch < 0: quantum efficiency, mirror reflectivity, and atmospheric */
+                /* transmission have already been applied in CORSIKA (CEFFIC option); ignored) */
+                lambda = 1. / ( 1. / fWavelengthMin - fRandom->Uniform( 1. ) * ( 1. / fWavelengthMin - 1. / fWavelengthMax ) );
+            }
+            else
+                /* Wavelength already generated in Corsika */ // (GM) for non-standard CORSIKA
+            {
+                lambda = wl_bunch;
+            }
+
+            // atmospheric extinction
+            if( lambda >= 1000 )
+            {
+                continue;
+            }
+            else if( lambda >= 0 )
+            {
+                prob = fAtmos->probAtmAbsorbed( lambda, ( double )iBunches[ibunch].zem * 0.01, -1. * cz );
+            }
+            else
+            {
+                prob = 1.;
+            }
+            iExtinctionTimer.stop();
+            // fill photon structure
+            Chphoton.photons = 1.;
+            Chphoton.x = iBunches[ibunch].x * 0.01 + iArray.xtel[iTel] * 0.01;
+            Chphoton.y = iBunches[ibunch].y * 0.01 + iArray.ytel[iTel] * 0.01;
+            Chphoton.cx = iBunches[ibunch].cx;
+            Chphoton.cy = iBunches[ibunch].cy;
+            Chphoton.ctime = corstime;
+            Chphoton.zem = iBunches[ibunch].zem * 0.01;
+            Chphoton.lambda = lambda;
+
+            // fill generated photons into histograms
+            if( fHisto && iOutput )
+            {
+                VStageTimer iTimer( iPhotonStats, VRunStatistics::HISTOGRAM_FILL, iPhotonWeight, false, false );
+                fHisto->fillGenerated( Chphoton, prob );
+            }
+            // extinction + efficiencies
+            VStageTimer iQETimer( iPhotonStats, VRunStatistics::QE_LENS, iPhotonWeight, false, false );
+            if( iBunches[ibunch].photons < 1. )
+            {
+                prob *= iBunches[ibunch].photons;
+            }
+            if( prob <= 1. )
+            {
+                // one random number for all efficiencies: survival with the minimum of the products
+                double iRand = fRandom->Uniform( 1. );
+                if( iRand > prob )
+                {
+                    continue;
+                }
+                //apply global quantum efficiency
+                prob *= fQueff;
+                if( iRand > prob )
+                {
+                    continue;
+                }
+                // apply PANOSETI quantum efficiency (NK)
+                prob *= VExpectedYield::getQuantumEfficiency( lambda );
+                if( iRand > prob )
+                {
+                    continue;
+                }
+                // apply PANOSETI lens transmission
+                prob *= VExpectedYield::getLensTransmission( lambda );
+                if( iRand > prob )
+                {
+                    continue;
+                }
+                iQETimer.stop();
+                // trigger emulation
+                if( bFillTrigger )
+                {
+                    fTrigger->fill( iTel, Chphoton );
+                }
+                if( !iOutput )
+                {
+                    continue;
+                }
+                // surviving photons (after quantum efficiency), filled and written per telescope
+                fSurvived.push_back( Chphoton );
+                fSurvivedProb.push_back( prob );
+            }
+        }
+    }
+    iPhotonLoopTimer.stop();
+
+    // fill number of photons per telescope (after extinction and efficiencies)
+    if( fExpected )
+    {
+        if( fStats )
+        {
+            fStats->countPhotons( 0., fExpectedPhotons );
+        }
+        if( fHisto )
+        {
+            fHisto->fillNPhotons( iTel, fExpectedPhotons );
+        }
+    }
+    else if( fSurvived.size() > 0 )
+    {
+        if( fStats )
+        {
+            fStats->countPhotons( 0., ( double )fSurvived.size() );
+        }
+        if( fHisto )
+        {
+            VStageTimer iTimer( fStats, VRunStatistics::HISTOGRAM_FILL );
+            fHisto->fillNPhotons( iTel, ( double )fSurvived.size() );
+            fHisto->fillSurvivedN( ( int )fSurvived.size(), &fSurvived[0], &fSurvivedProb[0], iTel );
+        }
+    }
+    return ( int )fSurvived.size();
+}
+
+/*!
+    end of array: expected wavelength spectra of all bunches of this array (counts-only mode and weighted bunches)
+*/
+void VBunchProcessor::endArray()
+{
+    if( !fExpected )
+    {
+        return;
+    }
+    if( fHisto )
+    {
+        fExpected->getSpectrum( fExpectedLambda, fExpectedGenerated, fExpectedDetected );
+        for( unsigned int k = 0; k < fExpectedLambda.size(); k++ )
+        {
+            fHisto->fillExpected( -1., fExpectedLambda[k], fExpectedGenerated[k], fExpectedDetected[k] );
+        }
+    }
+    fExpected->resetSpectrum();
+}
@@ -0,0 +1,208 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VCameraLayout
+    \brief focal plane pixelization of Cherenkov photon directions
+
+    Maps photon direction cosines (CORSIKA coordinates) onto a
+    rectangular grid of square pixels in the focal plane of each
+    telescope (default: PANOSETI, 32x32 pixels of 0.3 deg).
+
+    The focal plane position is the tangent of the angle between
+    photon direction and telescope axis (ideal optics). For a
+    vertically pointing telescope the focal plane x/y axes are the
+    CORSIKA x/y axes.
+
+    Pixel numbering: pixel = iy * NPIXX + ix (ix, iy starting at 0
+    at negative x, y). Photons outside the camera get pixel -1.
+
+    layout file (only lines starting with '*' are read):
+
+    \code
+    * CAMERA   NPIXX NPIXY PIXELSIZE[deg]
+    * TELPOINT TELID ZENITH[deg] AZIMUTH[deg]
+    \endcode
+
+    TELID counts from 1 (as telID in the output tree). Zenith and
+    azimuth follow the CORSIKA convention for the primary direction.
+    Telescopes without TELPOINT line point to the zenith.
+*/
+
+#include "VCameraLayout.h"
+
+VCameraLayout::VCameraLayout()
+{
+    fNPixX = 0;
+    fNPixY = 0;
+    fPixelSize_deg = 0.;
+    fTanPixelSize = 0.;
+    // PANOSETI
+    setCamera( 32, 32, 0.3 );
+}
+
+void VCameraLayout::setCamera( int iNPixX, int iNPixY, double iPixelSize_deg )
+{
+    fNPixX = iNPixX;
+    fNPixY = iNPixY;
+    fPixelSize_deg = iPixelSize_deg;
+    fTanPixelSize = tan( fPixelSize_deg * M_PI / 180. );
+}
+
+void VCameraLayout::setPointing( unsigned int iTel, double ze_deg, double az_deg )
+{
+    if( iTel >= fAxis.size() )
+    {
+        fPointingZe_deg.resize( iTel + 1, 0. );
+        fPointingAz_deg.resize( iTel + 1, 0. );
+        fAxis.resize( iTel + 1, vector< double >( 3, 0. ) );
+        fE1.resize( iTel + 1, vector< double >( 3, 0. ) );
+        fE2.resize( iTel + 1, vector< double >( 3, 0. ) );
+    }
+    double ze = ze_deg * M_PI / 180.;
+    double az = az_deg * M_PI / 180.;
+
+    fPointingZe_deg[iTel] = ze_deg;
+    fPointingAz_deg[iTel] = az_deg;
+
+    fAxis[iTel][0] = sin( ze ) * cos( az );
+    fAxis[iTel][1] = sin( ze ) * sin( az );
+    fAxis[iTel][2] = -1. * cos( ze );
+
+    fE1[iTel][0] = cos( ze ) * cos( az );
+    fE1[iTel][1] = cos( ze ) * sin( az );
+    fE1[iTel][2] = sin( ze );
+
+    fE2[iTel][0] = -1. * sin( az );
+    fE2[iTel][1] = cos( az );
+    fE2[iTel][2] = 0.;
+}
+
+/*!
+    read camera layout and telescope pointings from file
+*/
+bool VCameraLayout::readLayout( string iFile )
+{
+    ifstream is;
+    is.open( iFile.c_str(), ifstream::in );
+    if( !is )
+    {
+        cout << "VCameraLayout::readLayout error opening camera layout file " << iFile << endl;
+        return false;
+    }
+    string is_line;
+    string iTemp;
+    while( getline( is, is_line ) )
+    {
+        if( is_line.size() == 0 )
+        {
+            continue;
+        }
+        istringstream is_stream( is_line );
+        is_stream >> iTemp;
+        if( iTemp != "*" )
+        {
+            continue;
+        }
+        is_stream >> iTemp;
+        if( iTemp == "CAMERA" )
+        {
+            int nx = 0;
+            int ny = 0;
+            double iSize = 0.;
+            is_stream >> nx >> ny >> iSize;
+            if( nx <= 0 || ny <= 0 || iSize <= 0. )
+            {
+                cout << "VCameraLayout::readLayout error: invalid camera definition: " << is_line << endl;
+                return false;
+            }
+            setCamera( nx, ny, iSize );
+        }
+        else if( iTemp == "TELPOINT" )
+        {
+            int iTelID = 0;
+            double ze = 0.;
+            double az = 0.;
+            is_stream >> iTelID >> ze >> az;
+            if( iTelID <= 0 )
+            {
+                cout << "VCameraLayout::readLayout error: invalid telescope ID: " << is_line << endl;
+                return false;
+            }
+            setPointing( iTelID - 1, ze, az );
+        }
+    }
+    is.close();
+    return true;
+}
+
+/*!
+    pixel hit by a photon with direction cosines cx, cy in telescope iTel (counting from 0)
+
+    returns -1 for photons outside the camera
+*/
+int VCameraLayout::getPixel( int iTel, double cx, double cy ) const
+{
+    double cz = 1. - cx * cx - cy * cy;
+    if( cz < 0. )
+    {
+        return -1;
+    }
+    cz = -1. * sqrt( cz );
+
+    double u = cx;
+    double v = cy;
+    double d = -1. * cz;
+    if( iTel >= 0 && iTel < ( int )fAxis.size() && fAxis[iTel][2] != 0. )
+    {
+        const vector< double >& a = fAxis[iTel];
+        const vector< double >& e1 = fE1[iTel];
+        const vector< double >& e2 = fE2[iTel];
+        d = cx * a[0] + cy * a[1] + cz * a[2];
+        u = cx * e1[0] + cy * e1[1] + cz * e1[2];
+        v = cx * e2[0] + cy * e2[1] + cz * e2[2];
+    }
+    if( d <= 0. )
+    {
+        return -1;
+    }
+    double fx = u / ( d * fTanPixelSize ) + 0.5 * fNPixX;
+    double fy = v / ( d * fTanPixelSize ) + 0.5 * fNPixY;
+    if( fx < 0. || fy < 0. )
+    {
+        return -1;
+    }
+    int ix = ( int )fx;
+    int iy = ( int )fy;
+    if( ix >= fNPixX || iy >= fNPixY )
+    {
+        return -1;
+    }
+    return iy * fNPixX + ix;
+}
+
+void VCameraLayout::print() const
+{
+    cout << "camera layout: " << fNPixX << " x " << fNPixY << " pixels of " << fPixelSize_deg << " deg" << endl;
+    for( unsigned int i = 0; i < fPointingZe_deg.size(); i++ )
+    {
+        if( fAxis[i][2] != 0. )
+        {
+            cout << "\t telescope " << i + 1 << " pointing (ze, az): " << fPointingZe_deg[i] << ", " << fPointingAz_deg[i] << " deg" << endl;
+        }
+    }
+}
@@ -0,0 +1,656 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VEventProcessor
+    \brief processing of the blocks of a CORSIKA eventio file
+
+    Takes the blocks decoded by VEventReader and does everything
+    corsikaIOreader does with them: run header class and atmosphere
+    from the run and event headers, telescope selection, photon bunches
+    to detected photons (VBunchProcessor) for each array, trigger
+    decision (single or two passes over an array) and output in grisu
+    format and into histograms and trees.
+
+    \section example example
+
+    \code
+    VEventReader fReader;
+    fReader.open( "run1.corsika" );
+    VAtmosAbsorption fAtabso( "noExtinction", 0, "" );
+    TRandom3 fRandom( 0 );
+    VEventProcessor fProcessor( &fReader, &fAtabso, &fRandom );
+    fProcessor.setGrisuOutput( "run1.grisu" );
+    int iType = 0;
+    while( ( iType = fReader.next() ) >= 0 )
+    {
+        fProcessor.processBlock( iType );
+    }
+    fReader.close();
+    fProcessor.terminate();
+    \endcode
+*/
+
+#include "VEventProcessor.h"
+
+VEventProcessor::VEventProcessor( VEventReader* iReader, VAtmosAbsorption* iAtmos, TRandom3* iRandom, double iQueff, string iVersion )
+{
+    fReader = iReader;
+    fAtmos = iAtmos;
+    fRandom = iRandom;
+    fRandomEvent = *fRandom;
+    fQueff = iQueff;
+    fBunchProcessor = new VBunchProcessor( fAtmos, fRandom, fQueff );
+    fExpected = 0;
+    bWeightedBunches = false;
+
+    fVersion = iVersion;
+    bGRISU = false;
+    fGrisuOutputFile = "";
+    fAtmID = -1;
+    bPrintMoreInfo = false;
+    fHisto = 0;
+    fRunHeader = new VCORSIKARunheader();
+
+    fNTel = -1;
+    fNArray = -1;
+    fNArrayRead = 0;
+
+    fTrigger = 0;
+    bTriggerTwoPass = false;
+
+    bAtmProfile = false;
+    bRefraction = false;
+    bCEFFICWarning = true;
+
+    fStats = 0;
+    fTrace = 0;
+    fProgress = 0;
+    fPhotonsProcessed = 0.;
+}
+
+VEventProcessor::~VEventProcessor()
+{
+    for( unsigned int p = 0; p < fGrisu.size(); p++ )
+    {
+        delete fGrisu[p];
+    }
+    delete fBunchProcessor;
+    delete fRunHeader;
+}
+
+/*!
+    counts-only mode: expected number of detected photons per bunch instead of the photon loop
+    (no individual photons; not to be used with the trigger)
+
+    \param iWeightedBunches  write one record per bunch with its expected number of detected photons as weight
+                             into the grisu output ("B" lines; bunches below iWeightMin are merged)
+*/
+void VEventProcessor::setExpectedYield( VExpectedYield* iExpected, bool iWeightedBunches, double iWeightMin )
+{
+    fExpected = iExpected;
+    bWeightedBunches = ( fExpected && iWeightedBunches );
+    fBunchProcessor->setExpectedYield( fExpected, bWeightedBunches, iWeightMin );
+}
+
+/*!
+    write photons in grisu format into iFile ("stdout" for output to stdout)
+*/
+void VEventProcessor::setGrisuOutput( string iFile )
+{
+    bGRISU = true;
+    fGrisuOutputFile = iFile;
+}
+
+/*!
+    fill histograms and tree (iHisto must be initialised)
+*/
+void VEventProcessor::setHistograms( VIOHistograms* iHisto )
+{
+    fHisto = iHisto;
+    fBunchProcessor->setHistograms( fHisto );
+}
+
+/*!
+    print corsika event number and depth into the grisu output (needs atmosphere number)
+*/
+void VEventProcessor::setPrintMoreInfo( int iAtmID )
+{
+    fAtmID = iAtmID;
+    bPrintMoreInfo = true;
+}
+
+/*!
+    stage timers and counters (-stats) and timeline (-trace; set with VRunStatistics::setTrace())
+
+    (reader timers are set with VEventReader::setStatistics())
+*/
+void VEventProcessor::setStatistics( VRunStatistics* iStats )
+{
+    fStats = iStats;
+    fTrace = ( fStats ? fStats->getTrace() : 0 );
+    fBunchProcessor->setStatistics( fStats );
+}
+
+/*!
+    trigger emulation: only triggered events are written
+
+    \param iTwoPass  decide trigger in a first pass over the photons (no output for rejected events)
+*/
+void VEventProcessor::setTrigger( VTrigger* iTrigger, bool iTwoPass )
+{
+    fTrigger = iTrigger;
+    bTriggerTwoPass = ( fTrigger && iTwoPass );
+    fBunchProcessor->setTrigger( fTrigger, bTriggerTwoPass );
+}
+
+/*!
+    process the block read last by VEventReader::next() (iType: eventio block type)
+*/
+void VEventProcessor::processBlock( int iType )
+{
+    if( fProgress )
+    {
+        fProgress->update( fReader->getBytesRead(), fReader->getNEvents(), fPhotonsProcessed );
+    }
+    switch( iType )
+    {
+        /* CORSIKA run header */
+        case IO_TYPE_MC_RUNH:
+            readRunHeader();
+            break;
+
+        /* Telescope positions (relative positions in array) */
+        case IO_TYPE_MC_TELPOS:
+            fTelescopeMatrix = readTelescopeMatrix( fGrisuConfigurationFile, fReader->getArray().ntel,
+                                                    fReader->getArray().xtel, fReader->getArray().ytel );
+            initGrisu();
+            break;
+
+        /* CORSIKA event header */
+        case IO_TYPE_MC_EVTH:
+            readEventHeader();
+            break;
+
+        /* Photon data for a complete array (one of perhaps many instances) */
+        case IO_TYPE_MC_TELARRAY:
+            if( fNArrayRead >= fNArray && fNArray >= 0 )
+            {
+                break;
+            }
+            processArray();
+            fNArrayRead++;
+            break;
+
+        /* event trailer */
+        case IO_TYPE_MC_EVTE:
+            if( fTrace )
+            {
+                fTrace->end();
+            }
+            break;
+
+        /* run trailer, other material */
+        default:
+            break;
+    }
+}
+
+void VEventProcessor::readRunHeader()
+{
+    real* runh = fReader->getRunHeader();
+    telescope_array& array = fReader->getArray();
+
+    fBunchProcessor->setAirLightSpeed( fReader->getAirLightSpeed() );
+    // observation level from Corsika
+    if( array.obs_height > 0. )
+    {
+        fAtmos->setObservationlevel( array.obs_height * 0.01 );
+        if( fExpected )
+        {
+            fExpected->clearTable();
+        }
+        for( unsigned int p = 0; p < fGrisu.size(); p++ )
+        {
+            fGrisu[p]->setObservationHeight( array.obs_height * 0.01 );
+        }
+    }
+
+    // fill corsika run header class
+    fRunHeader->runnumber = ( unsigned int )runh[1];
+    fRunHeader->production_date = ( unsigned int )runh[2];
+    fRunHeader->corsika_version = ( float )runh[3];
+    fRunHeader->observation_level_m = ( float )array.mc_run.height;
+    fRunHeader->energy_slope = ( float )array.mc_run.slope;
+    fRunHeader->energy_min_GeV = ( float )array.mc_run.e_min;
+    fRunHeader->energy_max_GeV = ( float )array.mc_run.e_max;
+    fRunHeader->xscatt_m = ( float )runh[247] * 0.01;
+    fRunHeader->yscatt_m = ( float )runh[248] * 0.01;
+}
+
+/*!
+    initialize grisu writers (one for all telescopes or one per telescope)
+*/
+void VEventProcessor::initGrisu()
+{
+    if( fGrisu.size() > 0 )
+    {
+        return;
+    }
+    if( fNTel > -2 )
+    {
+        fGrisu.push_back( new VGrisu( fVersion, fAtmID ) );
+        if( fGrisuOutputFile.size() > 0 )
+        {
+            fGrisu.back()->setOutputfile( fGrisuOutputFile );
+        }
+    }
+    else if( fNTel == -2 )
+    {
+        char hO[2000];
+        for( int pt = 0; pt < fReader->getArray().ntel; pt++ )
+        {
+            fGrisu.push_back( new VGrisu( fVersion, fAtmID ) );
+            if( fGrisuOutputFile.size() > 0 )
+            {
+                sprintf( hO, "%s_%d", fGrisuOutputFile.c_str(), pt + 1 );
+                fGrisu.back()->setOutputfile( hO );
+            }
+        }
+    }
+    for( unsigned int pt = 0; pt < fGrisu.size(); pt++ )
+    {
+        fGrisu[pt]->setQueff( fQueff );
+        fGrisu[pt]->setWeightedBunches( bWeightedBunches );
+        // keep event output until the trigger decision
+        fGrisu[pt]->setEventBuffering( fTrigger && !bTriggerTwoPass );
+    }
+}
+
+void VEventProcessor::readEventHeader()
+{
+    real* evth = fReader->getEventHeader();
+    telescope_array& array = fReader->getArray();
+
+    if( fTrace )
+    {
+        ostringstream i_args;
+        i_args << "{\"event\":" << ( int )evth[1] << ",\"energy\":" << evth[3] << "}";
+        fTrace->begin( "event", "event", i_args.str() );
+    }
+    fBunchProcessor->setWavelengthRange( evth[95], evth[96] );
+    bitset<32> EVTH76 = ( unsigned long int )evth[76];
+    if( EVTH76.test( 2 ) && bCEFFICWarning )
+    {
+        cout << endl;
+        cout << "WARNING: ignoring any efficiencies applied in CORSIKA (CEFFIC options)" << endl;
+        cout << endl;
+        bCEFFICWarning = false;
+    }
+    fRunHeader->particleID = ( unsigned int )evth[2];
+    fRunHeader->startingaltitude_gcm2 = ( float )evth[4];
+    fRunHeader->tstart = ( int )evth[6];
+    fRunHeader->nscatt = ( unsigned int )evth[97];
+    fRunHeader->zenith_min_deg = ( float )evth[80];
+    fRunHeader->zenith_max_deg = ( float )evth[81];
+    fRunHeader->azimuth_min_deg = ( float )evth[82];
+    fRunHeader->azimuth_max_deg = ( float )evth[83];
+    fRunHeader->viewcone_min_deg = ( float )evth[152];
+    fRunHeader->viewcone_max_deg = ( float )evth[153];
+    fRunHeader->cherenkov_flag = ( unsigned long int )( evth[76] + 0.5 );
+    fRunHeader->cherenkov_bunchsize = ( float )evth[84];
+    fRunHeader->cherenkov_bandwidth_min_nm = ( float )evth[95];
+    fRunHeader->cherenkov_bandwidth_max_nm = ( float )evth[96];
+    fRunHeader->geomagneticfield_arrang_deg = ( float )evth[92];
+    fRunHeader->geomagneticfield_x_muT = ( float )evth[70];
+    fRunHeader->geomagneticfield_z_muT = ( float )evth[71];
+    fRunHeader->hadronic_model_low = ( unsigned int )evth[74];
+    fRunHeader->hadronic_model_high = ( unsigned int )evth[75];
+    fRunHeader->hadronic_model_transition_energy_GeV = ( float )evth[154];
+    if( !bAtmProfile )
+    {
+        // read atmospheric profile from CHERENKOV OPTIONS
+        EVTH76 >>= 10;
+        int iatmo = ( int )EVTH76.to_ulong();
+        if( iatmo <= 0 )
+        {
+            iatmo = 6;    /* US standard atmosphere */
+        }
+        try
+        {
+            atmset_( &iatmo, &array.obs_height );
+        }
+        catch(...)
+        {
+            cout << "error initialising atmospheres" << endl;
+            cout << "...exiting" << endl;
+            exit( EXIT_FAILURE );
+        }
+        bAtmProfile = true;
+
+        // refraction tables (CHERENKOV OPTIONS bit 4: refraction already applied in CORSIKA)
+        if( bRefraction )
+        {
+            if( ( ( unsigned long int )( evth[76] + 0.5 ) ) & ( 1 << 4 ) )
+            {
+                cout << "refraction already applied in CORSIKA; ignoring -refraction" << endl;
+                bRefraction = false;
+            }
+            else
+            {
+                fRefraction.fillTables( array.obs_height );
+                fBunchProcessor->setRefraction( &fRefraction );
+            }
+        }
+    }
+
+    if( fReader->getNEvents() == 0 && bGRISU )
+    {
+        for( unsigned int p = 0; p < fGrisu.size(); p++ )
+        {
+            fGrisu[p]->setObservationHeight( array.obs_height * 0.01 );
+            fGrisu[p]->writeRunHeader( evth, fRunHeader );
+        }
+    }
+    fNArrayRead = 0;
+}
+
+/*!
+    photon bunches of all telescopes of the current array
+
+    trigger emulation: in two-pass mode, the first pass over the photons fills
+    the trigger only; triggered events are read again (with identical random
+    numbers) and written in the second pass. In single-pass mode, the output
+    is buffered and discarded for events which did not trigger.
+*/
+void VEventProcessor::processArray()
+{
+    if( !fReader->beginArray() )
+    {
+        return;
+    }
+    telescope_array& array = fReader->getArray();
+    if( fTrace )
+    {
+        ostringstream i_args;
+        i_args << "{\"array\":" << fReader->getArrayID() << "}";
+        fTrace->begin( "array", "array", i_args.str() );
+    }
+
+    bool bTriggerPass = ( fTrigger && bTriggerTwoPass );
+    if( fTrigger )
+    {
+        fTrigger->reset();
+    }
+    if( bTriggerPass )
+    {
+        fRandomEvent = *fRandom;
+    }
+    for( int iPass = ( bTriggerPass ? 0 : 1 ); iPass < 2; iPass++ )
+    {
+        bool bOutput = ( iPass == 1 );
+        if( bOutput )
+        {
+            if( bTriggerPass )
+            {
+                if( !fTrigger->evaluate() )
+                {
+                    break;
+                }
+                fReader->rewindArray();
+                *fRandom = fRandomEvent;
+            }
+            if( fHisto )
+            {
+                // (tree of the previous event is filled here)
+                VStageTimer iTimer( fStats, VRunStatistics::ROOT_WRITE );
+                fHisto->newEvent( fReader->getEventHeader(), array, fReader->getArrayID() );    // start new event for each array
+            }
+            if( bGRISU )
+            {
+                VStageTimer iTimer( fStats, VRunStatistics::GRISU_WRITE );
+                for( unsigned int p = 0; p < fGrisu.size(); p++ )
+                {
+                    fGrisu[p]->writeEvent( array, bPrintMoreInfo );
+                }
+            }
+        }
+
+        int i_tel = 0;
+        while( ( i_tel = fReader->nextTelescope() ) != 0 )
+        {
+            VTraceSpan iTelescopeSpan( fTrace, "telescope", "telescope" );
+            /* Photon bunches for one telescope (error messages printed by the reader) */
+            if( i_tel < 0 )
+            {
+                if( fStats && bOutput )
+                {
+                    fStats->countTelescope( true );
+                }
+                continue;
+            }
+            int itel = fReader->getTelescopeID();
+            if( fTrace )
+            {
+                ostringstream i_args;
+                i_args << "{\"tel\":" << itel << ",\"bunches\":" << fReader->getNBunches() << ",\"pass\":" << iPass << "}";
+                iTelescopeSpan.setArgs( i_args.str() );
+            }
+            bool bSkipTelescope = ( fNTel >= 0 && itel != fNTel );
+            // check if this telescope should be analysed
+            if( itel < ( int )fTelescopeMatrix.size() && fTelescopeMatrix[itel] < 0 )
+            {
+                bSkipTelescope = true;
+            }
+            // (counted in the output pass only: triggered arrays are decoded twice in two-pass mode)
+            if( fStats && bOutput )
+            {
+                fStats->countTelescope( bSkipTelescope );
+                fStats->countBunches( fReader->getNBunches() );
+            }
+            if( bSkipTelescope )
+            {
+                continue;
+            }
+            if( fProgress && bOutput )
+            {
+                fPhotonsProcessed += fReader->getPhotons();
+                fProgress->update( fReader->getBytesRead(), fReader->getNEvents(), fPhotonsProcessed );
+            }
+            // photon bunches to detected photons (trigger and histograms are filled by the bunch processor)
+            if( fBunchProcessor->processTelescope( fReader->getBunches(), fReader->getNBunches(), array, itel, bOutput ) == 0 )
+            {
+                continue;
+            }
+            // write photons to iotxt output file (after quantum efficiency)
+            if( bGRISU )
+            {
+                VStageTimer iTimer( fStats, VRunStatistics::GRISU_WRITE );
+                writePhotons( itel, fBunchProcessor->getSurvived() );
+            }
+        } /* End of loop over telescopes */
+    } /* End of loop over passes */
+    // counts-only mode and weighted bunches: expected wavelength spectra of all bunches of this array
+    fBunchProcessor->endArray();
+    // trigger decision (single pass: output of rejected events is discarded)
+    if( fTrigger && !bTriggerTwoPass )
+    {
+        bool bTriggered = fTrigger->evaluate();
+        if( fHisto && !bTriggered )
+        {
+            fHisto->discardEvent();
+        }
+        for( unsigned int p = 0; p < fGrisu.size(); p++ )
+        {
+            if( bTriggered )
+            {
+                fGrisu[p]->commitEvent();
+            }
+            else
+            {
+                fGrisu[p]->discardEvent();
+            }
+        }
+    }
+    fReader->endArray();
+    if( fTrace )
+    {
+        fTrace->end();
+    }
+}
+
+/*!
+    write the surviving photons of telescope iTel in grisu format
+*/
+void VEventProcessor::writePhotons( int iTel, vector< bunch >& iPhotons )
+{
+    if( fNTel > -2 )
+    {
+        if( fGrisu.size() == 1 )
+        {
+            fGrisu[0]->writePhotonsN( ( int )iPhotons.size(), &iPhotons[0], fTelescopeMatrix[iTel] );
+        }
+    }
+    else if( fNTel == -2 )
+    {
+        // move all photons around coordinates centre
+        telescope_array& array = fReader->getArray();
+        for( unsigned int p = 0; p < iPhotons.size(); p++ )
+        {
+            iPhotons[p].x -= array.xtel[iTel] / 1.e2;
+            iPhotons[p].y -= array.ytel[iTel] / 1.e2;
+        }
+        // telescope ID is always 0
+        if( iTel < ( int )fGrisu.size() )
+        {
+            fGrisu[iTel]->writePhotonsN( ( int )iPhotons.size(), &iPhotons[0], 0 );
+        }
+    }
+}
+
+/*!
+    end of run: write histograms and close the grisu output
+
+    \param iPrint  print trigger statistics and run header
+*/
+void VEventProcessor::terminate( bool iPrint )
+{
+    if( fTrigger && iPrint )
+    {
+        fTrigger->printStatistics();
+    }
+    if( fHisto )
+    {
+        VStageTimer iTimer( fStats, VRunStatistics::ROOT_WRITE );
+        fHisto->terminate();
+    }
+    // (closing flushes the grisu output buffers)
+    VStageTimer iGrisuCloseTimer( fStats, VRunStatistics::GRISU_WRITE );
+    for( unsigned int p = 0; p < fGrisu.size(); p++ )
+    {
+        delete fGrisu[p];
+    }
+    fGrisu.clear();
+    iGrisuCloseTimer.stop();
+    if( iPrint )
+    {
+        if( fRunHeader )
+        {
+            fRunHeader->printHeader( cout );
+        }
+        cout << endl;
+        cout << "END OF RUN ( " << fReader->getNEvents() << " showers )" << endl;
+    }
+}
+
+/*
+     read telescopes matrix to convert corsika telescope numbers to a subset for grisudet
+
+     (example: corsika simulated for 5 telescopes, but grisudet should be for 4)
+
+*/
+vector< int > VEventProcessor::readTelescopeMatrix( string iCFGFile, int ntel, double* xtel, double* ytel )
+{
+    vector< int > m( ntel, 0 );
+    for( int i = 0; i < ntel; i++ )
+    {
+        m[i] = i;
+    }
+
+    if( iCFGFile.size() == 0 )
+    {
+        return m;
+    }
+    for( int i = 0; i < ntel; i++ )
+    {
+        m[i] = -1;
+    }
+
+    ifstream is;
+    is.open( iCFGFile.c_str(), ifstream::in );
+    if( !is )
+    {
+        cout << "readTelescopeMatrix error opening grisudet cfg file " << iCFGFile << endl;
+        cout << "...exiting" << endl;
+        exit( -1 );
+    }
+    unsigned int iTelID;
+    double x = 0.;
+    double y = 0.;
+    string iTemp;
+    string is_line;
+
+    while( getline( is, is_line ) )
+    {
+        if( is_line.size() > 0 )
+        {
+            istringstream is_stream( is_line );
+            is_stream >> iTemp;
+            if( iTemp != "*" )
+            {
+                continue;
+            }
+            is_stream >> iTemp;
+            if( iTemp != "TLLOC" )
+            {
+                continue;
+            }
+
+            is_stream >> iTemp;
+            iTelID = atoi( iTemp.c_str() );
+            is_stream >> iTemp;
+            x = atof( iTemp.c_str() );
+            is_stream >> iTemp;
+            y = atof( iTemp.c_str() );
+
+            // check which telescope position is consistent here
+            // observe: corsika in cm
+            // observe: corsika and grisudet have different coordinate systems
+            // observe: ignore z coordinate
+            for( int i = 0; i < ntel; i++ )
+            {
+                if( sqrt( ( x + ytel[i] / 1.e2 ) * ( x + ytel[i] / 1.e2 ) + ( y - xtel[i] / 1.e2 ) * ( y - xtel[i] / 1.e2 ) ) < 0.5 )
+                {
+                    m[i] = iTelID - 1;
+                }
+            }
+        }
+    }
+    is.close();
+
+    return m;
+}
@@ -0,0 +1,518 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VEventReader
+    \brief streaming reader for CORSIKA eventio files
+
+    Reads the blocks of a CORSIKA eventio file one after another and
+    decodes run header, telescope positions, event header, array
+    offsets and trailers into a telescope_array structure (based on
+    sim_skeleton.c in the CORSIKA IACT package).
+
+    Photon bunches are read per telescope into a decode buffer owned
+    by the reader; getBunches() points into this buffer, which is
+    overwritten by the next call of nextTelescope().
+
+    \code
+    VEventReader r;
+    r.open( "file.io" );
+    int type;
+    while( ( type = r.next() ) >= 0 )
+    {
+        if( type == IO_TYPE_MC_TELARRAY && r.beginArray() )
+        {
+            int i_status;
+            while( ( i_status = r.nextTelescope() ) != 0 )
+            {
+                if( i_status < 0 ) continue;
+                // r.getTelescopeID(), r.getBunches(), r.getNBunches()
+            }
+            r.endArray();
+        }
+    }
+    \endcode
+*/
+
+#include "VEventReader.h"
+
+#include <sys/stat.h>
+
+/*! Refraction index of air as a function of height in km (0km<=h<=8km) */
+#define Nair(hkm) (1.+0.0002814*exp(-0.0947982*(hkm)-0.00134614*(hkm)*(hkm)))
+
+#ifndef Nint
+#define Nint(x) ((x)>0?(int)((x)+0.5):(int)((x)-0.5))
+#endif
+
+/* ------------------- line_point_distance --------------------- */
+/**
+ *  Distance between a straight line and a point in space
+ *
+ *  @param  x1,y1,z1  reference point on the line
+ *  @param  cx,cy,cz  direction cosines of the line
+ *  @param  x,y,z     point in space
+ *
+ *  @return distance
+ *
+*/
+
+static double line_point_distance( double x1, double y1, double z1,
+                                   double cx, double cy, double cz,
+                                   double x, double y, double z )
+{
+    double a, a1, a2, a3, b;
+
+    a1 = ( y - y1 ) * cz - ( z - z1 ) * cy;
+    a2 = ( z - z1 ) * cx - ( x - x1 ) * cz;
+    a3 = ( x - x1 ) * cy - ( y - y1 ) * cx;
+    a  = a1 * a1 + a2 * a2 + a3 * a3;
+    b = cx * cx + cy * cy + cz * cz;
+    if( a < 0. || b <= 0. )
+    {
+        return -1;
+    }
+    return sqrt( a / b );
+}
+
+VEventReader::VEventReader( int iMaxBunches )
+{
+    bDebug = false;
+    bPrintHeaders = false;
+    fStats = 0;
+
+    for( int i = 0; i < 273; i++ )
+    {
+        runh[i] = rune[i] = evth[i] = evte[i] = 0.;
+    }
+    fInputs.text = NULL;
+    fInputs.next = NULL;
+
+    // value initialization: all zero
+    fArray = new telescope_array();
+    fAltitude = 0.;
+    fAzimuth = 0.;
+    fAirLightSpeed = 29.9792458 / 1.0002256; /* [cm/ns] at H=2200 m */
+    fNEvent = 0;
+    fBytesRead = 0;
+    fFileSize = 0;
+
+    fMaxBunches = iMaxBunches;
+    fBunches = new bunch[fMaxBunches];
+    fNBunches = 0;
+    fPhotons = 0.;
+    fTelescopeID = 0;
+    fArrayID = 0;
+    fNTelescopesRead = 0;
+
+    /* I/O buffer for input needed */
+    if( ( iobuf = allocate_io_buffer( 0 ) ) == NULL )
+    {
+        fprintf( stderr, "Input I/O buffer not allocated\n" );
+        exit( 1 );
+    }
+    iobuf->max_length = numeric_limits<long>::max();
+    //   iobuf->max_length = 10000000000;
+}
+
+VEventReader::~VEventReader()
+{
+    close();
+    free_io_buffer( iobuf );
+    delete [] fBunches;
+    delete fArray;
+}
+
+/*!
+    open CORSIKA eventio file (returns false if file cannot be opened)
+*/
+bool VEventReader::open( string iFile )
+{
+    close();
+    fFileName = iFile;
+    FILE* data_file = fopen( fFileName.c_str(), "r" );
+    if( data_file == NULL )
+    {
+        perror( fFileName.c_str() );
+        return false;
+    }
+    iobuf->input_file = data_file;
+    fNEvent = 0;
+    fBytesRead = 0;
+    struct stat st;
+    fFileSize = ( fstat( fileno( data_file ), &st ) == 0 && S_ISREG( st.st_mode ) ? ( long long )st.st_size : 0 );
+    return true;
+}
+
+void VEventReader::close()
+{
+    if( iobuf && iobuf->input_file )
+    {
+        fclose( iobuf->input_file );
+        iobuf->input_file = NULL;
+    }
+}
+
+/*!
+    find and read the next block of data
+
+    Header and trailer blocks are decoded; for telescope array blocks
+    (IO_TYPE_MC_TELARRAY) call beginArray() to read the photons.
+
+    \return block type, or -1 at the end of the file (or after an error; the rest of the input is skipped)
+*/
+int VEventReader::next()
+{
+    if( !iobuf->input_file )
+    {
+        return -1;
+    }
+    double t_block = ( fStats ? VRunStatistics::now() : 0. );
+    //possible return values: 0 (O.k.),  -1 (error),  or  -2 (end-of-file)
+    VStageTimer iFindTimer( fStats, VRunStatistics::BLOCK_FIND, 1., false );
+    int i_find = find_io_block( iobuf, &fBlockHeader );
+    iFindTimer.stop();
+
+    if( i_find != 0 )
+    {
+        switch( i_find )
+        {
+            case -1:
+                cerr << "VEventReader: There was an error finding the next IO block; will skip the rest of the input." << endl;
+                break;
+
+            case -2:
+                break;
+
+            default:
+                cerr << "VEventReader: There was an undefined error finding the next IO block; find_io_block returned " << i_find << "." << endl;
+        }
+        return -1;
+    }
+
+    // block length (without the 16 bytes of sync marker, type, identifier and length)
+    long i_length = iobuf->item_length[0];
+
+    // block reading and decoding of headers
+    VStageTimer iReadTimer( fStats, VRunStatistics::BLOCK_READ, 1., false );
+    //possible return values:  0 (O.k.), -1 (error), -2 (end-of-file), -3 (block skipped because it is too large).
+    int i_block = read_io_block( iobuf, &fBlockHeader );
+
+    if( i_block != 0 )
+    {
+        switch( i_block )
+        {
+            case -1:
+                cerr << "VEventReader: There was an error reading the next IO block; will skip the rest of the input." << endl;
+                break;
+
+            case -2:
+                break;
+
+            case -3:
+                cerr << "VEventReader: There was an error reading the next IO block (block skipper because it is too large); will skip the rest of the input." << endl;
+                break;
+
+            default:
+                cerr << "VEventReader: There was an undefined error reading the next IO block; read_io_block returned " << i_block << "." << endl;
+        }
+        return -1;
+    }
+
+    fBytesRead += i_length + 16;
+    if( fStats )
+    {
+        fStats->countBlock( fBlockHeader.type, i_length + 16 );
+    }
+
+    /* What did we actually get? */
+    switch( fBlockHeader.type )
+    {
+        /* CORSIKA run header */
+        case IO_TYPE_MC_RUNH:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_RUNH" << endl;
+            }
+            readRunHeader();
+            break;
+
+        /* CORSIKA inputs */
+        case IO_TYPE_MC_INPUTCFG:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_INPUTCFG" << endl;
+            }
+            read_input_lines( iobuf, &fInputs );
+            freeInputLines();
+            break;
+
+        /* Telescope positions (relative positions in array) */
+        case IO_TYPE_MC_TELPOS:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_TELPOS" << endl;
+            }
+            read_tel_pos( iobuf, MAX_TEL, &fArray->ntel, fArray->xtel, fArray->ytel, fArray->ztel, fArray->rtel );
+            break;
+
+        /* CORSIKA event header */
+        case IO_TYPE_MC_EVTH:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_EVTH" << endl;
+            }
+            if( bDebug )
+            {
+                cout << "reading IO_TYPE_MC_EVTH" << endl;
+            }
+            readEventHeader();
+            break;
+
+        /* Offsets of telescope array instances for the following event */
+        case IO_TYPE_MC_TELOFF:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_TELOFF" << endl;
+            }
+            read_tel_offset( iobuf, MAX_ARRAY, &fArray->narray, &fArray->toff, fArray->xoff, fArray->yoff );
+            fArray->mc_run.num_arrays = fArray->narray;
+            if( bDebug )
+            {
+                cout << "\t total number of arrays simulated: " << fArray->mc_run.num_arrays << endl;
+            }
+            break;
+
+        /* Photon data for a complete array (one of perhaps many instances); read with beginArray() */
+        case IO_TYPE_MC_TELARRAY:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_TELARRAY" << endl;
+            }
+            break;
+
+        /* CORSIKA event trailer */
+        case IO_TYPE_MC_EVTE:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_EVTE" << endl;
+            }
+            read_tel_block( iobuf, IO_TYPE_MC_EVTE, evte, 273 );
+            fNEvent++;
+            /* All array instances for this shower are finished */
+            break;
+
+        /* CORSIKA run trailer */
+        case IO_TYPE_MC_RUNE:
+            if( bPrintHeaders )
+            {
+                cout << "IO_TYPE_MC_RUNE" << endl;
+            }
+            read_tel_block( iobuf, IO_TYPE_MC_RUNE, rune, 273 );
+            break;
+
+        /* Unknown / any other material */
+        default:
+            if( bPrintHeaders )
+            {
+                cout << "Read block header of type " << fBlockHeader.type << ", will ignore." << endl;
+            }
+            break;
+    }
+    iReadTimer.stop();
+    // one span per block (find, read and decoding)
+    if( fStats && fStats->getTrace() )
+    {
+        ostringstream i_args;
+        i_args << "{\"type\":" << fBlockHeader.type << ",\"bytes\":" << i_length + 16 << "}";
+        fStats->getTrace()->complete( "block " + VRunStatistics::getBlockName( fBlockHeader.type ), "io",
+                                      t_block, VRunStatistics::now() - t_block, i_args.str() );
+    }
+    return ( int )fBlockHeader.type;
+}
+
+void VEventReader::readRunHeader()
+{
+    read_tel_block( iobuf, IO_TYPE_MC_RUNH, runh, 273 );
+    int nht = ( int )runh[4];
+    if( nht > 0 && nht <= 10 )
+    {
+        fArray->obs_height = runh[4 + nht];
+    }
+    else
+    {
+        fArray->obs_height = -100;
+    }
+    if( bDebug )
+    {
+        printf( "Run %d: observation level is at %6.1f m\n", ( int )runh[1], 0.01 * fArray->obs_height );
+    }
+    fAirLightSpeed = 29.9792458 / Nair( 1e-5 * fArray->obs_height );
+    if( bDebug )
+    {
+        printf( "Events created between %5.3f and %5.3f TeV\n", ( double )runh[16] / 1e3, ( double )runh[17] / 1e3 );
+    }
+    /* CORSIKA run information in run header */
+    fArray->mc_run.height = fArray->obs_height * 0.01;
+    fArray->mc_run.e_min = runh[16] * 0.001;
+    fArray->mc_run.e_max = runh[17] * 0.001;
+    fArray->mc_run.slope = runh[15];
+    /* Further information has to wait for event header */
+    fArray->mc_run.radius = 0.;
+    fArray->mc_run.num_arrays = 0;
+    fArray->mc_run.theta_min = fArray->mc_run.theta_max = -1.;
+    fArray->mc_run.phi_min = fArray->mc_run.phi_max = -1.;
+    fArray->mc_run.wlen_min = fArray->mc_run.wlen_max = 0.;
+}
+
+void VEventReader::readEventHeader()
+{
+    read_tel_block( iobuf, IO_TYPE_MC_EVTH, evth, 273 );
+
+    fArray->shower_sim.energy = 0.001 * evth[3]; /* in TeV */
+    fArray->shower_sim.xmax = fArray->shower_sim.emax = fArray->shower_sim.cmax = 0.;
+    fArray->shower_sim.hmax = 0.;
+    int particle_type = Nint( evth[2] );
+    if( bDebug )
+    {
+        printf( "Event %d: particle type %d with energy %5.2f TeV \n", ( int )evth[1], particle_type, 0.001 * evth[3] );
+    }
+    fAltitude = 90. - ( 180. / M_PI ) * evth[10];
+    //(GM) keep Corsika coordinate system            az  = 180. - (180./M_PI)*(evth[11]-evth[92]);
+    fAzimuth = ( 180. / M_PI ) * ( evth[11] - evth[92] );
+    fAzimuth -= floor( fAzimuth / 360. ) * 360.;
+    if( bDebug )
+    {
+        printf( "   zenith angle %4.2f deg, azimuth %4.2f deg\n", 90. - fAltitude, fAzimuth );
+    }
+
+    fArray->mc_run.theta_min = evth[80];
+    fArray->mc_run.theta_max = evth[81];
+    fArray->mc_run.phi_max = 180. - ( evth[82] - evth[92] );
+    fArray->mc_run.phi_min = 180. - ( evth[83] - evth[92] );
+    fArray->mc_run.bunchsize = evth[84];
+    fArray->mc_run.wlen_min = evth[95];
+    fArray->mc_run.wlen_max = evth[96];
+
+    fArray->shower_sim.azimuth = fAzimuth;
+    fArray->shower_sim.altitude = fAltitude;
+    fArray->shower_sim.firstint = abs( evth[6] * 0.01 );
+    fArray->shower_sim.shower_id = evth[1];
+    fArray->shower_sim.particle = particle_type;
+}
+
+void VEventReader::freeInputLines()
+{
+    if( fInputs.text != NULL )
+    {
+        struct linked_string* xl, *xln;
+        for( xl = &fInputs; xl != NULL; xl = xln )
+        {
+            free( xl->text );
+            xl->text = NULL;
+            xln = xl->next;
+            xl->next = NULL;
+            if( xl != &fInputs )
+            {
+                free( xl );
+            }
+        }
+        fflush( stdout );
+    }
+}
+
+/*!
+    start reading of the current telescope array block (shower core position and distances)
+*/
+bool VEventReader::beginArray()
+{
+    if( fBlockHeader.type != IO_TYPE_MC_TELARRAY )
+    {
+        return false;
+    }
+    VStageTimer iTimer( fStats, VRunStatistics::PHOTON_DECODE );
+    if( begin_read_tel_array( iobuf, &fItemHeader, &fArrayID ) < 0 )
+    {
+        return false;
+    }
+    fNTelescopesRead = 0;
+
+    fArray->shower_sim.xcore = -0.01 * fArray->xoff[fArrayID]; /* in meters */
+    fArray->shower_sim.ycore = -0.01 * fArray->yoff[fArrayID]; /* in meters */
+    if( bDebug )
+    {
+        cout << "\t shower core for array " << fArrayID << " at (x/m) [m]: " << fArray->shower_sim.xcore << "\t" << fArray->shower_sim.ycore << endl;
+    }
+    /* Observation level is now defining z=0.: */
+    fArray->shower_sim.zcore = 0.; /* Note: this is below lowest telescope */
+
+    double cx = -1.*cos( fAltitude * ( M_PI / 180. ) ) * cos( fAzimuth * ( M_PI / 180. ) );
+    double cy = -1.*cos( fAltitude * ( M_PI / 180. ) ) * sin( fAzimuth * ( M_PI / 180. ) );
+    double cz = sin( fAltitude * ( M_PI / 180. ) );
+    fArray->shower_sim.core_dist_3d =
+        line_point_distance( fArray->shower_sim.xcore, fArray->shower_sim.ycore, fArray->shower_sim.zcore,
+                             cx, cy, cz, 0.01 * fArray->refpos[0], 0.01 * fArray->refpos[1], 0.01 * fArray->refpos[2] );
+    /* Distances of telescopes from shower axis */
+    for( int itel = 0; itel < fArray->max_tel; itel++ )
+    {
+        fArray->shower_sim.tel_core_dist_3d[itel] = line_point_distance( fArray->shower_sim.xcore, fArray->shower_sim.ycore, fArray->shower_sim.zcore, cx, cy, cz, 0.01 * fArray->xtel[itel], 0.01 * fArray->ytel[itel], 0.01 * fArray->ztel[itel] );
+    }
+    return true;
+}
+
+/*!
+    read photon bunches of the next telescope of the current array
+
+    \return 1 (bunches read), 0 (no more telescopes), -1 (error reading this telescope; continue with the next one)
+*/
+int VEventReader::nextTelescope()
+{
+    if( fNTelescopesRead >= fArray->ntel )
+    {
+        return 0;
+    }
+    fNTelescopesRead++;
+    VStageTimer iTimer( fStats, VRunStatistics::PHOTON_DECODE );
+    fSubItemHeader.type = IO_TYPE_MC_PHOTONS;
+    if( search_sub_item( iobuf, &fItemHeader, &fSubItemHeader ) < 0 )
+    {
+        fNTelescopesRead = fArray->ntel;
+        return 0;
+    }
+    int jarray = 0;
+    fTelescopeID = 0;
+    if( read_tel_photons( iobuf, fMaxBunches, &jarray, &fTelescopeID, &fPhotons, fBunches, &fNBunches ) < 0 )
+    {
+        fprintf( stderr, "Error reading %d photon bunches\n", fNBunches );
+        return -1;
+    }
+    return 1;
+}
+
+/*!
+    rewind to the first telescope of the current array (e.g. for a second pass over all photons)
+*/
+bool VEventReader::rewindArray()
+{
+    fNTelescopesRead = 0;
+    return ( rewind_item( iobuf, &fItemHeader ) >= 0 );
+}
+
+void VEventReader::endArray()
+{
+    end_read_tel_array( iobuf, &fItemHeader );
+}
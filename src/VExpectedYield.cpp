@@ -0,0 +1,307 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VExpectedYield
+    \brief expected number of detected photons per bunch (counts-only mode, -countsonly)
+
+    Instead of sampling a wavelength and a survival decision for each
+    photon, the detection efficiency (atmospheric extinction, global
+    quantum efficiency, PANOSETI quantum efficiency and lens transmission)
+    is integrated over the 1/lambda^2 Cherenkov spectrum between the
+    wavelength limits of the CORSIKA event header. The expected number
+    of detected photons of a bunch is the number of photons in the bunch
+    times this integrated efficiency.
+
+    The efficiency of a photon is the same as in the photon loop: one
+    random number is compared to the product of the efficiencies after
+    each step, i.e. the photon survives with the minimum of these products.
+
+    Integrated efficiencies are tabulated in emission height (1 km steps,
+    0-120 km) and direction cosine (0.02 steps, 0.1-1) and interpolated
+    bilinearly; bunches outside the table are integrated directly.
+    The wavelength integration steps correspond to the bins of the
+    wavelength histograms (2 nm), so that the expected spectra of
+    generated and detected photons can be filled into these histograms.
+*/
+
+#include "VExpectedYield.h"
+
+VExpectedYield::VExpectedYield( VAtmosAbsorption* iAtmos, double iQueff, double iBinWidth )
+{
+    fAtmos = iAtmos;
+    fQueff = iQueff;
+    fBinWidth = ( iBinWidth > 0. ? iBinWidth : 2. );
+    fWavelengthMin = -1.;
+    fWavelengthMax = -1.;
+    fHeightStep = 1000.;
+    fNHeight = 121;
+    fCosMin = 0.1;
+    fCosStep = 0.02;
+    fNCos = 46;
+    fGenerated = 0.;
+}
+
+/*!
+    PANOSETI quantum efficiency (lambda in [nm])
+*/
+double VExpectedYield::getQuantumEfficiency( double iLambda )
+{
+    return 0.9189 / ( 1. + ( exp( -0.2046 * ( iLambda - 384.2 ) ) ) );
+}
+
+/*!
+    PANOSETI lens transmission (lambda in [nm])
+*/
+double VExpectedYield::getLensTransmission( double iLambda )
+{
+    return ( ( -3.244e-11 * pow( iLambda, 4 ) ) + ( 9.376e-8 * pow( iLambda, 3 ) ) + ( -9.880e-5 * pow( iLambda, 2 ) ) + ( 4.402e-2 * iLambda ) - 6.623 );
+}
+
+/*!
+    detection probability of a photon with wavelength iLambda [nm],
+    emission height iZem [m] and direction cosine iCosZ
+*/
+double VExpectedYield::getEfficiency( double iLambda, double iZem, double iCosZ )
+{
+    if( iLambda >= 1000. )
+    {
+        return 0.;
+    }
+    double prob = 1.;
+    if( iLambda >= 0. && fAtmos )
+    {
+        prob = fAtmos->probAtmAbsorbed( iLambda, iZem, iCosZ );
+    }
+    if( prob > 1. )
+    {
+        return 0.;
+    }
+    double iEff = prob;
+    prob *= fQueff;
+    iEff = ( prob < iEff ? prob : iEff );
+    prob *= getQuantumEfficiency( iLambda );
+    iEff = ( prob < iEff ? prob : iEff );
+    prob *= getLensTransmission( iLambda );
+    iEff = ( prob < iEff ? prob : iEff );
+    return ( iEff > 0. ? iEff : 0. );
+}
+
+/*!
+    set wavelength interval of the 1/lambda^2 spectrum [nm] (table is recalculated if the interval changes)
+*/
+void VExpectedYield::setWavelengthRange( double iMin, double iMax )
+{
+    if( iMin == fWavelengthMin && iMax == fWavelengthMax )
+    {
+        return;
+    }
+    fWavelengthMin = iMin;
+    fWavelengthMax = iMax;
+    fillTable();
+}
+
+/*!
+    force recalculation of the table (e.g. new observation level)
+*/
+void VExpectedYield::clearTable()
+{
+    fWavelengthMin = -1.;
+    fWavelengthMax = -1.;
+    fLambda.clear();
+    fWeight.clear();
+    fEfficiency.clear();
+    fMeanEfficiency.clear();
+    fNodePhotons.clear();
+    fNodeFilled.clear();
+    fDirectDetected.clear();
+    fGenerated = 0.;
+}
+
+void VExpectedYield::fillTable()
+{
+    fLambda.clear();
+    fWeight.clear();
+    if( fWavelengthMin > 0. && fWavelengthMax > fWavelengthMin )
+    {
+        double iNorm = 1. / fWavelengthMin - 1. / fWavelengthMax;
+        for( int j = ( int )( fWavelengthMin / fBinWidth ); j * fBinWidth < fWavelengthMax; j++ )
+        {
+            double l0 = ( j * fBinWidth > fWavelengthMin ? j * fBinWidth : fWavelengthMin );
+            double l1 = ( ( j + 1 ) * fBinWidth < fWavelengthMax ? ( j + 1 ) * fBinWidth : fWavelengthMax );
+            if( l1 <= l0 )
+            {
+                continue;
+            }
+            // photons >= 1000 nm are not generated (as in the photon loop)
+            if( 0.5 * ( l0 + l1 ) >= 1000. )
+            {
+                break;
+            }
+            fLambda.push_back( 0.5 * ( l0 + l1 ) );
+            fWeight.push_back( ( 1. / l0 - 1. / l1 ) / iNorm );
+        }
+    }
+    unsigned int n = fLambda.size();
+    unsigned int iNodes = fNHeight * fNCos;
+    fEfficiency.assign( iNodes * n, 0. );
+    fMeanEfficiency.assign( iNodes, 0. );
+    for( int h = 0; h < fNHeight; h++ )
+    {
+        for( int c = 0; c < fNCos; c++ )
+        {
+            unsigned int iNode = h * fNCos + c;
+            double iSum = 0.;
+            for( unsigned int k = 0; k < n; k++ )
+            {
+                double e = getEfficiency( fLambda[k], h * fHeightStep, fCosMin + c * fCosStep );
+                fEfficiency[iNode * n + k] = e;
+                iSum += fWeight[k] * e;
+            }
+            fMeanEfficiency[iNode] = iSum;
+        }
+    }
+    fNodePhotons.assign( iNodes, 0. );
+    fNodeFilled.clear();
+    fDirectDetected.assign( n, 0. );
+    fGenerated = 0.;
+    cout << "VExpectedYield: efficiency table for wavelengths " << fWavelengthMin << " - " << fWavelengthMax;
+    cout << " nm (" << n << " wavelength steps, " << iNodes << " nodes)" << endl;
+}
+
+/*!
+    detection efficiency integrated over the 1/lambda^2 spectrum
+    (emission height iZem in [m], direction cosine iCosZ)
+*/
+double VExpectedYield::getIntegratedEfficiency( double iZem, double iCosZ )
+{
+    double h = iZem / fHeightStep;
+    double c = ( iCosZ - fCosMin ) / fCosStep;
+    if( iCosZ <= 1. && c > fNCos - 1. )
+    {
+        c = fNCos - 1.;
+    }
+    if( h < 0. || c < 0. || h > fNHeight - 1. || c > fNCos - 1. )
+    {
+        double iSum = 0.;
+        for( unsigned int k = 0; k < fLambda.size(); k++ )
+        {
+            iSum += fWeight[k] * getEfficiency( fLambda[k], iZem, iCosZ );
+        }
+        return iSum;
+    }
+    int ih = ( ( int )h < fNHeight - 1 ? ( int )h : fNHeight - 2 );
+    int ic = ( ( int )c < fNCos - 1 ? ( int )c : fNCos - 2 );
+    double fh = h - ih;
+    double fc = c - ic;
+    unsigned int iNode = ih * fNCos + ic;
+    return ( 1. - fh ) * ( 1. - fc ) * fMeanEfficiency[iNode] + ( 1. - fh ) * fc * fMeanEfficiency[iNode + 1]
+           + fh * ( 1. - fc ) * fMeanEfficiency[iNode + fNCos] + fh * fc * fMeanEfficiency[iNode + fNCos + 1];
+}
+
+/*!
+    expected number of detected photons of a bunch with iPhotons photons
+    (emission height iZem in [m], direction cosine iCosZ)
+
+    the bunch is added to the spectra of generated and detected photons
+*/
+double VExpectedYield::addBunch( double iPhotons, double iZem, double iCosZ )
+{
+    unsigned int n = fLambda.size();
+    if( n == 0 || iPhotons <= 0. )
+    {
+        return 0.;
+    }
+    fGenerated += iPhotons;
+
+    double h = iZem / fHeightStep;
+    double c = ( iCosZ - fCosMin ) / fCosStep;
+    if( iCosZ <= 1. && c > fNCos - 1. )
+    {
+        c = fNCos - 1.;
+    }
+    // outside of the table: direct integration
+    if( h < 0. || c < 0. || h > fNHeight - 1. || c > fNCos - 1. )
+    {
+        double iSum = 0.;
+        for( unsigned int k = 0; k < n; k++ )
+        {
+            double e = iPhotons * fWeight[k] * getEfficiency( fLambda[k], iZem, iCosZ );
+            fDirectDetected[k] += e;
+            iSum += e;
+        }
+        return iSum;
+    }
+    int ih = ( ( int )h < fNHeight - 1 ? ( int )h : fNHeight - 2 );
+    int ic = ( ( int )c < fNCos - 1 ? ( int )c : fNCos - 2 );
+    double fh = h - ih;
+    double fc = c - ic;
+    unsigned int iNode[4] = { ( unsigned int )( ih * fNCos + ic ), ( unsigned int )( ih * fNCos + ic + 1 ),
+                              ( unsigned int )( ( ih + 1 ) * fNCos + ic ), ( unsigned int )( ( ih + 1 ) * fNCos + ic + 1 )
+                            };
+    double w[4] = { ( 1. - fh ) * ( 1. - fc ), ( 1. - fh ) * fc, fh * ( 1. - fc ), fh * fc };
+    double iSum = 0.;
+    for( unsigned int i = 0; i < 4; i++ )
+    {
+        if( w[i] <= 0. )
+        {
+            continue;
+        }
+        if( fNodePhotons[iNode[i]] == 0. )
+        {
+            fNodeFilled.push_back( iNode[i] );
+        }
+        fNodePhotons[iNode[i]] += iPhotons * w[i];
+        iSum += w[i] * fMeanEfficiency[iNode[i]];
+    }
+    return iPhotons * iSum;
+}
+
+/*!
+    expected spectra of generated and detected photons of all bunches added since the last resetSpectrum()
+*/
+void VExpectedYield::getSpectrum( vector< double >& iLambda, vector< double >& iGenerated, vector< double >& iDetected )
+{
+    unsigned int n = fLambda.size();
+    iLambda = fLambda;
+    iGenerated.assign( n, 0. );
+    iDetected = fDirectDetected;
+    for( unsigned int k = 0; k < n; k++ )
+    {
+        iGenerated[k] = fGenerated * fWeight[k];
+    }
+    for( unsigned int i = 0; i < fNodeFilled.size(); i++ )
+    {
+        double iPhotons = fNodePhotons[fNodeFilled[i]];
+        const double* e = &fEfficiency[( unsigned long )fNodeFilled[i] * n];
+        for( unsigned int k = 0; k < n; k++ )
+        {
+            iDetected[k] += iPhotons * fWeight[k] * e[k];
+        }
+    }
+}
+
+void VExpectedYield::resetSpectrum()
+{
+    for( unsigned int i = 0; i < fNodeFilled.size(); i++ )
+    {
+        fNodePhotons[fNodeFilled[i]] = 0.;
+    }
+    fNodeFilled.clear();
+    fDirectDetected.assign( fLambda.size(), 0. );
+    fGenerated = 0.;
+}
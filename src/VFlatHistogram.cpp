@@ -0,0 +1,149 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VFlatHistogram
+    \brief fixed-bin histogram accumulator
+
+    Contiguous bin array with the same bin numbering, under/overflow
+    handling and statistics as ROOT's TH1D/TH2D. Photons are filled
+    into this accumulator during an event; the result is copied into
+    the TH1D/TH2D written to the tree once per event.
+
+    Only bins filled since the last reset are copied and cleared,
+    and only the bins written by the previous copy are cleared in
+    the ROOT histogram, which keeps large, sparsely filled 2D
+    histograms cheap.
+*/
+
+#include "VFlatHistogram.h"
+
+VFlatHistogram::VFlatHistogram( int nx, double xmin, double xmax, int ny, double ymin, double ymax )
+{
+    fNx = ( nx > 0 ? nx : 1 );
+    fNy = ( ny > 0 ? ny : 0 );
+    fXmin = xmin;
+    fXmax = xmax;
+    fYmin = ymin;
+    fYmax = ymax;
+    fXscale = ( fXmax > fXmin ? fNx / ( fXmax - fXmin ) : 0. );
+    fYscale = ( fNy > 0 && fYmax > fYmin ? fNy / ( fYmax - fYmin ) : 0. );
+
+    unsigned int n = ( fNx + 2 ) * ( fNy > 0 ? fNy + 2 : 1 );
+    fBins.assign( n, 0. );
+    fTouched.assign( n, 0 );
+    fCopyTarget = 0;
+
+    fEntries = 0.;
+    for( int i = 0; i < 7; i++ )
+    {
+        fStats[i] = 0.;
+    }
+}
+
+/*!
+    add contents and statistics of another accumulator with the same binning
+*/
+void VFlatHistogram::add( const VFlatHistogram& h )
+{
+    if( h.fBins.size() != fBins.size() )
+    {
+        return;
+    }
+    for( unsigned int i = 0; i < h.fFilledBins.size(); i++ )
+    {
+        addToBin( h.fFilledBins[i], h.fBins[h.fFilledBins[i]] );
+    }
+    fEntries += h.fEntries;
+    for( int i = 0; i < 7; i++ )
+    {
+        fStats[i] += h.fStats[i];
+    }
+}
+
+/*!
+    fill n values (unit weights if w is not given)
+*/
+void VFlatHistogram::fillN( int n, const double* x, const double* w )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        fill( x[i], ( w ? w[i] : 1. ) );
+    }
+}
+
+/*!
+    fill n pairs of values (unit weights if w is not given)
+*/
+void VFlatHistogram::fillN2D( int n, const double* x, const double* y, const double* w )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        fill2D( x[i], y[i], ( w ? w[i] : 1. ) );
+    }
+}
+
+/*!
+    replace contents and statistics of the ROOT histogram h
+
+    h must have the same binning as this accumulator and is expected
+    to be written by this accumulator only (bins written by the previous
+    copy are cleared; any other histogram is reset completely)
+*/
+void VFlatHistogram::copyTo( TH1* h )
+{
+    if( !h )
+    {
+        return;
+    }
+    if( h == fCopyTarget )
+    {
+        for( unsigned int i = 0; i < fCopiedBins.size(); i++ )
+        {
+            h->SetBinContent( fCopiedBins[i], 0. );
+        }
+    }
+    else
+    {
+        h->Reset();
+        fCopyTarget = h;
+    }
+    for( unsigned int i = 0; i < fFilledBins.size(); i++ )
+    {
+        h->SetBinContent( fFilledBins[i], fBins[fFilledBins[i]] );
+    }
+    fCopiedBins.assign( fFilledBins.begin(), fFilledBins.end() );
+    h->SetEntries( fEntries );
+    double iStats[7];
+    memcpy( iStats, fStats, sizeof( iStats ) );
+    h->PutStats( iStats );
+}
+
+void VFlatHistogram::reset()
+{
+    for( unsigned int i = 0; i < fFilledBins.size(); i++ )
+    {
+        fBins[fFilledBins[i]] = 0.;
+        fTouched[fFilledBins[i]] = 0;
+    }
+    fFilledBins.clear();
+    fEntries = 0.;
+    for( int i = 0; i < 7; i++ )
+    {
+        fStats[i] = 0.;
+    }
+}
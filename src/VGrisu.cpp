@@ -28,6 +28,10 @@
     photon lines:
       - ID of photon emitting particle not know from CORSIKA -> always 0
 
+    weighted bunch lines (setWeightedBunches()):
+      - "B" instead of "P", same fields followed by the weight of the bunch
+        (expected number of detected photons); wavelength 0 if not known
+
     \author
          Gernot Maier
 
@@ -43,6 +47,10 @@ VGrisu::VGrisu( string iVersion, int id )
     
     fVersion = iVersion;
     bSTDOUT = false;
+    bBufferEvent = false;
+    bWeightedBunches = false;
+    fEventBuffer.setf( ios::fixed | ios::right );
+    fEventBuffer.precision( 4 );
     
     primID = 0;
     xoff = 0;
@@ -57,6 +65,18 @@ VGrisu::VGrisu( string iVersion, int id )
     makeParticleMap();
 }
 
+VGrisu::~VGrisu()
+{
+    if( of_file.is_open() )
+    {
+        of_file.close();
+    }
+    if( bSTDOUT )
+    {
+        cout.flush();
+    }
+}
+
 /*!
     create grisu output file
     \param ofile name of grisu output file
@@ -200,7 +220,7 @@ void VGrisu::writeRunHeader( float* buf1, VCORSIKARunheader* f )
    write shower line ("S")
    \param array  MC run information
 */
-void VGrisu::writeEvent( telescope_array array, bool printMoreInfo )
+void VGrisu::writeEvent( const telescope_array& array, bool printMoreInfo )
 {
     float phi = array.shower_sim.azimuth / degrad;
     float ze = ( 90. - array.shower_sim.altitude ) / degrad;
@@ -229,47 +249,23 @@ void VGrisu::writeEvent( telescope_array array, bool printMoreInfo )
         thick = thickx_( &ih ) / cos( ze );
     }
     
-    if( !bSTDOUT )
-    {
-        of_file << "S";
-        of_file << " " << setprecision( 7 ) << array.shower_sim.energy;         // energy in TeV
-        of_file << " " << setprecision( 7 ) << x;
-        of_file << " " << setprecision( 7 ) << y;
-        of_file << " " << setprecision( 7 ) << dcos;
-        of_file << " " << setprecision( 7 ) << dsin;
-        of_file << " " << setprecision( 7 ) << array.shower_sim.firstint;
-        of_file << " " << -1;
-        of_file << " " << -1;
-        of_file << " " << -1;
-        of_file << endl;
-    }
-    else
-    {
-        cout << "S";
-        cout << " " << setprecision( 7 ) << array.shower_sim.energy;         // energy in TeV
-        cout << " " << setprecision( 7 ) << x;
-        cout << " " << setprecision( 7 ) << y;
-        cout << " " << setprecision( 7 ) << dcos;
-        cout << " " << setprecision( 7 ) << dsin;
-        cout << " " << setprecision( 7 ) << array.shower_sim.firstint;
-        cout << " " << -1;
-        cout << " " << -1;
-        cout << " " << -1;
-        cout << endl;
-    }
+    ostream& os = getEventStream();
+    os << "S";
+    os << " " << setprecision( 7 ) << array.shower_sim.energy;         // energy in TeV
+    os << " " << setprecision( 7 ) << x;
+    os << " " << setprecision( 7 ) << y;
+    os << " " << setprecision( 7 ) << dcos;
+    os << " " << setprecision( 7 ) << dsin;
+    os << " " << setprecision( 7 ) << array.shower_sim.firstint;
+    os << " " << -1;
+    os << " " << -1;
+    os << " " << -1;
+    os << endl;
     
     //additional corsika information in separate line. Format is "C", first interaction height, first interaction depth, corsika shower id.
     if( printMoreInfo )
     {
-        if( !bSTDOUT )
-        {
-            of_file << "C " <<  setprecision( 7 ) << array.shower_sim.firstint  << " " << thick <<  " " << array.shower_sim.shower_id << endl;
-        }
-        else
-        {
-            cout <<  "C " <<  setprecision( 7 ) << array.shower_sim.firstint  << " " << thick <<  " " << array.shower_sim.shower_id << endl;
-        }
-        
+        os << "C " <<  setprecision( 7 ) << array.shower_sim.firstint  << " " << thick <<  " " << array.shower_sim.shower_id << endl;
     }
     
 }
@@ -281,9 +277,34 @@ void VGrisu::writeEvent( telescope_array array, bool printMoreInfo )
     \param i_tel   telescope number
 
 */
-void VGrisu::writePhotons( bunch i_bunch, int i_tel )
+void VGrisu::writePhotons( const bunch& i_bunch, int i_tel )
 {
+    ostream& os = getEventStream();
+    os.setf( ios::showpos );
+    writePhotonLine( os, i_bunch, i_tel );
+    os.unsetf( ios::showpos );
+}
+
+/*!
+    write n photons to grisu file ("P" lines)
+
+    \param n      number of photons
+    \param ph     photon information
+    \param i_tel  telescope number
+*/
+void VGrisu::writePhotonsN( int n, const bunch* ph, int i_tel )
+{
+    ostream& os = getEventStream();
+    os.setf( ios::showpos );
+    for( int i = 0; i < n; i++ )
+    {
+        writePhotonLine( os, ph[i], i_tel );
+    }
+    os.unsetf( ios::showpos );
+}
 
+void VGrisu::writePhotonLine( ostream& os, const bunch& i_bunch, int i_tel )
+{
     float x = i_bunch.x;
     float y = i_bunch.y;
     float az = atan2( i_bunch.cy, i_bunch.cx );
@@ -300,45 +321,68 @@ void VGrisu::writePhotons( bunch i_bunch, int i_tel )
     
     transformCoord( az, x, y );
     
-    if( !bSTDOUT )
+    os << ( bWeightedBunches ? "B" : "P" ) << " ";
+    os << setprecision( 7 ) << x << " ";
+    os << setprecision( 7 ) << y << " ";
+    os << setprecision( 7 ) << sin( ze ) * cos( az ) << " ";
+    os << setprecision( 7 ) << sin( ze ) * sin( az ) << " ";
+    os << setprecision( 7 ) << i_bunch.zem << " ";
+    os << setprecision( 7 ) << i_bunch.ctime << " ";             // !! not relative time since emission,
+    // but time since first interaction
+    os << ( int )i_bunch.lambda  << " " ;                        // in nanometer
+    os << 3  << " ";                                             // the type of the particle emitting the photon,
+    // (not know from CORSIKA)
+    os << i_tel + 1;                                                   // the detector hit (negative integer number)
+    if( bWeightedBunches )
     {
-        of_file.setf( ios::showpos );
-        of_file << "P" << " ";
-        of_file << setprecision( 7 ) << x << " ";
-        of_file << setprecision( 7 ) << y << " ";
-        of_file << setprecision( 7 ) << sin( ze ) * cos( az ) << " ";
-        of_file << setprecision( 7 ) << sin( ze ) * sin( az ) << " ";
-        of_file << setprecision( 7 ) << i_bunch.zem << " ";
-        of_file << setprecision( 7 ) << i_bunch.ctime << " ";             // !! not relative time since emission,
-        // but time since first interaction
-        of_file << ( int )i_bunch.lambda  << " " ;                        // in nanometer
-        of_file << 3  << " ";                                             // the type of the particle emitting the photon,
-        // (not know from CORSIKA)
-        of_file << i_tel + 1;                                                   // the detector hit (negative integer number)
-        of_file << endl;
-        
-        of_file.unsetf( ios::showpos );
+        os << " " << setprecision( 7 ) << i_bunch.photons;               // weight of the bunch
+    }
+    os << "\n";
+}
+
+/*!
+    output stream for event and photon lines
+
+    (event buffer if output is held back until the trigger decision)
+*/
+ostream& VGrisu::getEventStream()
+{
+    if( bBufferEvent )
+    {
+        return fEventBuffer;
+    }
+    if( bSTDOUT )
+    {
+        return cout;
+    }
+    return of_file;
+}
+
+/*!
+    write the buffered event and photon lines to the output file
+*/
+void VGrisu::commitEvent()
+{
+    if( !bBufferEvent )
+    {
+        return;
+    }
+    if( bSTDOUT )
+    {
+        cout << fEventBuffer.str();
+        cout.flush();
     }
     else
     {
-        cout.setf( ios::showpos );
-        cout << "P" << " ";
-        cout << setprecision( 7 ) << x << " ";
-        cout << setprecision( 7 ) << y << " ";
-        cout << setprecision( 7 ) << sin( ze ) * cos( az ) << " ";
-        cout << setprecision( 7 ) << sin( ze ) * sin( az ) << " ";
-        cout << setprecision( 7 ) << i_bunch.zem << " ";
-        cout << setprecision( 7 ) << i_bunch.ctime << " ";             // !! not relative time since emission,
-        // but time since first interaction
-        cout << ( int )i_bunch.lambda  << " " ;                        // in nanometer
-        cout << 3  << " ";                                             // the type of the particle emitting the photon,
-        // (not know from CORSIKA)
-        cout << i_tel + 1;                                                   // the detector hit (negative integer number)
-        cout << endl;
-        
-        
-        cout.unsetf( ios::showpos );
+        of_file << fEventBuffer.str();
     }
+    discardEvent();
+}
+
+void VGrisu::discardEvent()
+{
+    fEventBuffer.str( "" );
+    fEventBuffer.clear();
 }
 
 /*!
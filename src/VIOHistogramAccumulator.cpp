@@ -0,0 +1,408 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VIOHistogramAccumulator
+    \brief per-worker accumulator for VIOHistograms
+
+    Holds everything VIOHistograms fills per photon during an event
+    (histogram partials, photons per telescope, photon vectors).
+
+    VIOHistograms keeps one accumulator for the current event. Workers
+    processing parts of an event in parallel fill their own accumulators
+    (VIOHistograms::newAccumulator()) and hand them over with
+    VIOHistograms::commit(). Each accumulator is tagged with setOrder()
+    with the event (VIOHistograms::getEventIndex()) and its part within
+    the event, in the order in which a serial run would have filled the
+    photons (e.g. telescope order). commit() accepts the parts of the
+    current event in this order only, so the tree is identical to the
+    one of a serial run.
+*/
+
+#include "VIOHistogramAccumulator.h"
+
+VIOHistogramAccumulator::VIOHistogramAccumulator( bool iFillHistograms, bool iCORSIKA_coordinates )
+{
+    bFillHistograms = iFillHistograms;
+    bCORSIKA_coordinates = iCORSIKA_coordinates;
+    fEvent = -1;
+    fPart = -1;
+    bFillPhotons = true;
+
+    fT0 = 0;
+    fZem = 0;
+    fGLambda = 0;
+    fGProb = 0;
+    fGZem = 0;
+    fSXY = 0;
+    fSLambda = 0;
+    fSProb = 0;
+    fSZem = 0;
+    
+    fCamera = 0;
+    fTimeBinWidth = 0.;
+    fTimeMin = 0.;
+    fNTimeBins = 0;
+    bArrivalTimes = false;
+}
+
+/*!
+    copy with the same configuration and binning (contents are copied as well)
+*/
+VIOHistogramAccumulator::VIOHistogramAccumulator( const VIOHistogramAccumulator& iAcc )
+{
+    bFillHistograms = iAcc.bFillHistograms;
+    bCORSIKA_coordinates = iAcc.bCORSIKA_coordinates;
+    fEvent = -1;
+    fPart = -1;
+    bFillPhotons = iAcc.bFillPhotons;
+
+    fT0 = ( iAcc.fT0 ? new VFlatHistogram( *iAcc.fT0 ) : 0 );
+    fZem = ( iAcc.fZem ? new VFlatHistogram( *iAcc.fZem ) : 0 );
+    fGLambda = ( iAcc.fGLambda ? new VFlatHistogram( *iAcc.fGLambda ) : 0 );
+    fGProb = ( iAcc.fGProb ? new VFlatHistogram( *iAcc.fGProb ) : 0 );
+    fGZem = ( iAcc.fGZem ? new VFlatHistogram( *iAcc.fGZem ) : 0 );
+    fSXY = ( iAcc.fSXY ? new VFlatHistogram( *iAcc.fSXY ) : 0 );
+    fSLambda = ( iAcc.fSLambda ? new VFlatHistogram( *iAcc.fSLambda ) : 0 );
+    fSProb = ( iAcc.fSProb ? new VFlatHistogram( *iAcc.fSProb ) : 0 );
+    fSZem = ( iAcc.fSZem ? new VFlatHistogram( *iAcc.fSZem ) : 0 );
+    for( unsigned int i = 0; i < iAcc.fCXYZ.size(); i++ )
+    {
+        fCXYZ.push_back( new VFlatHistogram( *iAcc.fCXYZ[i] ) );
+    }
+    fXYZlevelsHeight = iAcc.fXYZlevelsHeight;
+    sortXYZlevels();
+
+    fNCp = iAcc.fNCp;
+    fCX = iAcc.fCX;
+    fCY = iAcc.fCY;
+    fTelID = iAcc.fTelID;
+    
+    fCamera = iAcc.fCamera;
+    fPixelCounts = iAcc.fPixelCounts;
+    fPixelFilled = iAcc.fPixelFilled;
+    fTimeBinWidth = iAcc.fTimeBinWidth;
+    fTimeMin = iAcc.fTimeMin;
+    fNTimeBins = iAcc.fNTimeBins;
+    fTimeCounts = iAcc.fTimeCounts;
+    bArrivalTimes = iAcc.bArrivalTimes;
+    fArrivalTel = iAcc.fArrivalTel;
+    fArrivalTime = iAcc.fArrivalTime;
+}
+
+VIOHistogramAccumulator::~VIOHistogramAccumulator()
+{
+    delete fT0;
+    delete fZem;
+    delete fGLambda;
+    delete fGProb;
+    delete fGZem;
+    delete fSXY;
+    delete fSLambda;
+    delete fSProb;
+    delete fSZem;
+    for( unsigned int i = 0; i < fCXYZ.size(); i++ )
+    {
+        delete fCXYZ[i];
+    }
+}
+
+void VIOHistogramAccumulator::initHistograms( int xybin, double xmax, double ymax, double zemax )
+{
+    if( !bFillHistograms )
+    {
+        return;
+    }
+    fT0 = new VFlatHistogram( 2000, -1000., 1000. );
+    fZem = new VFlatHistogram( 500, 0., zemax );
+    fGLambda = new VFlatHistogram( 400, 0., 800. );
+    fGProb = new VFlatHistogram( 100, 0., 1. );
+    fGZem = new VFlatHistogram( 500, 0., zemax );
+    fSXY = new VFlatHistogram( xybin, -1. * xmax, xmax, xybin, -1. * ymax, ymax );
+    fSLambda = new VFlatHistogram( 400, 0., 800. );
+    fSProb = new VFlatHistogram( 100, 0., 1. );
+    fSZem = new VFlatHistogram( 500, 0., zemax );
+}
+
+void VIOHistogramAccumulator::initXYZhistograms( vector< double > iXYZlevelsHeight, int xybin, double xmax, double ymax )
+{
+    fXYZlevelsHeight = iXYZlevelsHeight;
+    for( unsigned int i = 0; i < fXYZlevelsHeight.size(); i++ )
+    {
+        fCXYZ.push_back( new VFlatHistogram( xybin, -1. * xmax, xmax, xybin, -1. * ymax, ymax ) );
+    }
+    sortXYZlevels();
+}
+
+static bool higherLevel( const pair< double, VFlatHistogram* >& a, const pair< double, VFlatHistogram* >& b )
+{
+    return a.first > b.first;
+}
+
+/*!
+    order xyz levels by decreasing height
+
+    (getXYZlevels() delivers them already in this order)
+*/
+void VIOHistogramAccumulator::sortXYZlevels()
+{
+    vector< pair< double, VFlatHistogram* > > iL;
+    for( unsigned int i = 0; i < fXYZlevelsHeight.size() && i < fCXYZ.size(); i++ )
+    {
+        iL.push_back( make_pair( fXYZlevelsHeight[i], fCXYZ[i] ) );
+    }
+    stable_sort( iL.begin(), iL.end(), higherLevel );
+    
+    fXYZsortedHeight.clear();
+    fXYZsortedHisto.clear();
+    for( unsigned int i = 0; i < iL.size(); i++ )
+    {
+        fXYZsortedHeight.push_back( iL[i].first );
+        fXYZsortedHisto.push_back( iL[i].second );
+    }
+    fXYZxp.assign( iL.size(), 0. );
+    fXYZyp.assign( iL.size(), 0. );
+}
+
+/*!
+    add the contents of another accumulator (photon vectors are appended)
+*/
+void VIOHistogramAccumulator::add( const VIOHistogramAccumulator& iAcc )
+{
+    VFlatHistogram* iThis[] = { fT0, fZem, fGLambda, fGProb, fGZem, fSXY, fSLambda, fSProb, fSZem };
+    VFlatHistogram* iOther[] = { iAcc.fT0, iAcc.fZem, iAcc.fGLambda, iAcc.fGProb, iAcc.fGZem, iAcc.fSXY, iAcc.fSLambda, iAcc.fSProb, iAcc.fSZem };
+    for( unsigned int i = 0; i < sizeof( iThis ) / sizeof( iThis[0] ); i++ )
+    {
+        if( iThis[i] && iOther[i] )
+        {
+            iThis[i]->add( *iOther[i] );
+        }
+    }
+    for( unsigned int i = 0; i < fCXYZ.size() && i < iAcc.fCXYZ.size(); i++ )
+    {
+        fCXYZ[i]->add( *iAcc.fCXYZ[i] );
+    }
+
+    if( fNCp.size() < iAcc.fNCp.size() )
+    {
+        fNCp.resize( iAcc.fNCp.size(), 0. );
+    }
+    for( unsigned int i = 0; i < iAcc.fNCp.size(); i++ )
+    {
+        fNCp[i] += iAcc.fNCp[i];
+    }
+    fCX.insert( fCX.end(), iAcc.fCX.begin(), iAcc.fCX.end() );
+    fCY.insert( fCY.end(), iAcc.fCY.begin(), iAcc.fCY.end() );
+    fTelID.insert( fTelID.end(), iAcc.fTelID.begin(), iAcc.fTelID.end() );
+    for( unsigned int i = 0; i < iAcc.fPixelFilled.size(); i++ )
+    {
+        addPixel( iAcc.fPixelFilled[i], iAcc.fPixelCounts[iAcc.fPixelFilled[i]] );
+    }
+    unordered_map< long long, int >::const_iterator t_iter;
+    for( t_iter = iAcc.fTimeCounts.begin(); t_iter != iAcc.fTimeCounts.end(); ++t_iter )
+    {
+        fTimeCounts[t_iter->first] += t_iter->second;
+    }
+    fArrivalTel.insert( fArrivalTel.end(), iAcc.fArrivalTel.begin(), iAcc.fArrivalTel.end() );
+    fArrivalTime.insert( fArrivalTime.end(), iAcc.fArrivalTime.begin(), iAcc.fArrivalTime.end() );
+}
+
+void VIOHistogramAccumulator::addPixel( unsigned int iIndex, int iCounts )
+{
+    if( iIndex >= fPixelCounts.size() )
+    {
+        fPixelCounts.resize( iIndex + 1, 0 );
+    }
+    if( fPixelCounts[iIndex] == 0 )
+    {
+        fPixelFilled.push_back( iIndex );
+    }
+    fPixelCounts[iIndex] += iCounts;
+}
+
+void VIOHistogramAccumulator::reset()
+{
+    fEvent = -1;
+    fPart = -1;
+    VFlatHistogram* iThis[] = { fT0, fZem, fGLambda, fGProb, fGZem, fSXY, fSLambda, fSProb, fSZem };
+    for( unsigned int i = 0; i < sizeof( iThis ) / sizeof( iThis[0] ); i++ )
+    {
+        if( iThis[i] )
+        {
+            iThis[i]->reset();
+        }
+    }
+    for( unsigned int i = 0; i < fCXYZ.size(); i++ )
+    {
+        fCXYZ[i]->reset();
+    }
+    fNCp.assign( fNCp.size(), 0. );
+    fCX.clear();
+    fCY.clear();
+    fTelID.clear();
+    for( unsigned int i = 0; i < fPixelFilled.size(); i++ )
+    {
+        fPixelCounts[fPixelFilled[i]] = 0;
+    }
+    fPixelFilled.clear();
+    fTimeCounts.clear();
+    fArrivalTel.clear();
+    fArrivalTime.clear();
+}
+
+void VIOHistogramAccumulator::fillBunch( const bunch& i_bunch, double itime )
+{
+    if( bFillHistograms )
+    {
+        fT0->fill( itime );
+        fZem->fill( i_bunch.zem * 0.01 );
+    }
+}
+
+/*!
+    in corsika coordinates
+*/
+void VIOHistogramAccumulator::fillGenerated( const bunch& ph, double prob )
+{
+    if( bFillHistograms )
+    {
+        fGLambda->fill( ph.lambda );
+        fGProb->fill( prob );
+        fGZem->fill( ph.zem );
+    }
+}
+
+/*!
+    expected numbers of generated and detected photons (counts-only mode)
+
+    emission height iZem [m] (not filled for iZem < 0), wavelength iLambda [nm] (not filled for iLambda <= 0)
+*/
+void VIOHistogramAccumulator::fillExpected( double iZem, double iLambda, double iGenerated, double iDetected )
+{
+    if( !bFillHistograms )
+    {
+        return;
+    }
+    if( iZem >= 0. )
+    {
+        fGZem->fill( iZem, iGenerated );
+        fSZem->fill( iZem, iDetected );
+    }
+    if( iLambda > 0. )
+    {
+        fGLambda->fill( iLambda, iGenerated );
+        fSLambda->fill( iLambda, iDetected );
+    }
+}
+
+void VIOHistogramAccumulator::fillSurvived( const bunch& ph, double prob, int iTel )
+{
+    if( bArrivalTimes && iTel >= 0 )
+    {
+        fArrivalTel.push_back( iTel );
+        fArrivalTime.push_back( ph.ctime );
+    }
+    if( !bFillHistograms )
+    {
+        return;
+    }
+    fSProb->fill( prob );
+    fSLambda->fill( ph.lambda );
+    fSZem->fill( ph.zem );
+    if( !bFillPhotons )
+    {
+        return;
+    }
+
+    if( !bCORSIKA_coordinates )
+    {
+        fSXY->fill2D( ph.x, ph.y );
+    }
+    else
+    {
+        fSXY->fill2D( ph.y, -ph.x );
+    }
+
+    if( fCamera )
+    {
+        int iPixel = fCamera->getPixel( iTel, ph.cx, ph.cy );
+        if( iPixel >= 0 && iTel >= 0 )
+        {
+            addPixel( iTel * fCamera->getNPixels() + iPixel, 1 );
+            // arrival time [ns]
+            if( fTimeBinWidth > 0. && ph.ctime >= fTimeMin )
+            {
+                int iTimeBin = ( int )( ( ph.ctime - fTimeMin ) / fTimeBinWidth );
+                if( iTimeBin < fNTimeBins )
+                {
+                    fTimeCounts[( ( long long )iTel * fCamera->getNPixels() + iPixel ) * fNTimeBins + iTimeBin]++;
+                }
+            }
+        }
+    }
+    else
+    {
+        fCX.push_back( ph.cx );
+        fCY.push_back( ph.cy );
+        fTelID.push_back( iTel + 1 );
+    }
+
+    // fill xyz histograms (only levels below the emission height)
+    unsigned int n = fXYZsortedHeight.size();
+    if( n == 0 )
+    {
+        return;
+    }
+    unsigned int i_start = lower_bound( fXYZsortedHeight.begin(), fXYZsortedHeight.end(), ( double )ph.zem, greater< double >() ) - fXYZsortedHeight.begin();
+    
+    double x = ph.x;
+    double y = ph.y;
+    double cx = ph.cx;
+    double cy = ph.cy;
+    if( bCORSIKA_coordinates )
+    {
+        x = ph.y;
+        y = -ph.x;
+        cx = ph.cy;
+        cy = -ph.cx;
+    }
+    const double* h = fXYZsortedHeight.data();
+    double* xp = fXYZxp.data();
+    double* yp = fXYZyp.data();
+    for( unsigned int i = i_start; i < n; i++ )
+    {
+        xp[i] = x + h[i] * cx;
+        yp[i] = y + h[i] * cy;
+    }
+    for( unsigned int i = i_start; i < n; i++ )
+    {
+        fXYZsortedHisto[i]->fill2D( xp[i], yp[i] );
+    }
+}
+
+void VIOHistogramAccumulator::fillNPhotons( int iTel, double iphotons )
+{
+    if( iTel < 0 )
+    {
+        return;
+    }
+    if( iTel >= ( int )fNCp.size() )
+    {
+        fNCp.resize( iTel + 1, 0. );
+    }
+    fNCp[iTel] += iphotons;
+}
@@ -34,12 +34,47 @@ VIOHistograms::VIOHistograms()
 {
     hisList = new TList();
     nevent = 0;
+    fNextPart = 0;
+    bEventPending = false;
     degrad = 45. / atan( 1. );
     
     bCORSIKA_coordinates = false;
     
     bSmallFile = false;
     bMuon = false;
+    
+    fPhotonPrecision = 0;
+    CXYscale = 1.;
+    
+    fCompressionAlgorithm = -1;
+    fCompressionLevel = -1;
+    fBasketSize = 32000;
+    fAutoFlush = 0;
+    
+    hT0 = 0;
+    hZem = 0;
+    hGProb = 0;
+    hGZem = 0;
+    hSXY = 0;
+    hSLambda = 0;
+    hSProb = 0;
+    hSZem = 0;
+    hCXYZ = 0;
+    
+    fEventAcc = 0;
+    fCamera = 0;
+    timeBinWidth = 0.;
+    timeBinMin = 0.;
+    timeBinNumber = 0;
+    fCoincidence = 0;
+    coincWindow = 0.;
+    coincMultiplicity = 0;
+    
+    fout = 0;
+    fTree = 0;
+    fPhotonTree = 0;
+    bSplitTrees = false;
+    bWritePhotonTree = false;
 }
 
 void VIOHistograms::init( string i_outfile, bool iShort )
@@ -50,6 +85,14 @@ void VIOHistograms::init( string i_outfile, bool iShort )
         cout << "error while opening root output file: " << i_outfile.c_str() << endl;
         exit( -1 );
     }
+    if( fCompressionAlgorithm >= 0 )
+    {
+        fout->SetCompressionAlgorithm( fCompressionAlgorithm );
+    }
+    if( fCompressionLevel >= 0 )
+    {
+        fout->SetCompressionLevel( fCompressionLevel );
+    }
     if( bSmallFile )
     {
         cout << "\t\t smallfile output" << endl;
@@ -90,14 +133,6 @@ void VIOHistograms::init( string i_outfile, bool iShort )
         sprintf( htitle, "Cherenkov bunch size," );
         hBunch = new TH1D( hname, htitle, 600, 0., 6. );
         hBunch->SetXTitle( "bunch size" );
-        hZem = new TH1D( "hZem", "height of Cherenkov bunch emission", 500, 0., zemax );
-        hZem->SetXTitle( "height [m]" );
-        sprintf( hname, "hT0" );
-        sprintf( htitle, "Cherenkov bunch arrival times " );
-        hT0 = new TH1D( hname, htitle, 2000, -1000., 1000. );
-        hT0->SetXTitle( "arrival time [ns]" ),
-            hT0->SetLineColor( 2 );
-        hisList->Add( hT0 );
         
         sprintf( hname, "hGXY" );
         sprintf( htitle, "Cherenkov photon positions (no absorption/efficencies applied)" );
@@ -126,6 +161,17 @@ void VIOHistograms::init( string i_outfile, bool iShort )
         hisList->Add( hGZeAz );
         */ 
         
+        hZem = new TH1D( "hZem", "height of Cherenkov bunch emission", 500, 0., zemax );
+        hZem->SetXTitle( "height [m]" );
+        hisList->Add( hZem );
+        
+        sprintf( hname, "hT0" );
+        sprintf( htitle, "Cherenkov bunch arrival times " );
+        hT0 = new TH1D( hname, htitle, 2000, -1000., 1000. );
+        hT0->SetXTitle( "arrival time [ns]" );
+        hT0->SetLineColor( 2 );
+        hisList->Add( hT0 );
+        
         hGProb = new TH1D( "hGProb", "event survival probability (no absorption/efficencies applied)", 100, 0., 1. );
         hGProb->SetXTitle( "propability" );
         hisList->Add( hGProb );
@@ -204,7 +250,19 @@ void VIOHistograms::init( string i_outfile, bool iShort )
     }
     
     
+    fEventAcc = new VIOHistogramAccumulator( !bShort, bCORSIKA_coordinates );
+    fEventAcc->setFillPhotons( !bSplitTrees || bWritePhotonTree );
+    fEventAcc->initHistograms( xybin, xmax, ymax, zemax );
+    initRunHistograms();
+    fEventAcc->setCameraLayout( fCamera );
+    fEventAcc->setTimeBinning( timeBinWidth, timeBinMin, timeBinNumber );
+    fEventAcc->setArrivalTimes( fCoincidence != 0 );
+    
     fTree = new TTree( "tcors", "CORSIKA results" );
+    if( fAutoFlush != 0 )
+    {
+        fTree->SetAutoFlush( fAutoFlush );
+    }
     
     fTree->Branch( "eventNumber", &eventNumber, "eventNumber/I" );
     fTree->Branch( "arrayNumber", &arrayNumber, "arrayNumber/I" );
@@ -246,116 +304,151 @@ void VIOHistograms::init( string i_outfile, bool iShort )
     fTree->Branch( "rCore", &rCore, "rCore/D" );
     // number of Cherenkov photons per telescope
     fTree->Branch( "NCp", NCp, "NCp[telNumber]/D" );
-    fTree->Branch( "CX", &CX); //NK
-    fTree->Branch( "CY", &CY); //NK
-    fTree->Branch( "telID", &telID); //NK
-    //fTree->Branch( "CTime", &CTime); //NK
-    //fTree->Branch("CXCY", CXCY, "CXCY", &CXCY );
-
-    if( !bShort )
+    if( fCoincidence )
     {
-        /*
-        if( !bSmallFile )
-        {
-            fTree->Branch( "hGLambda", "TH1D", &hGLambda, 32000, 0 );
-        }
-        */
-        fTree->Branch( "hSLambda", "TH1D", &hSLambda, 32000, 0 );
-        //NK
-        /*
-        if( !bSmallFile )
-        {
-            fTree->Branch( "hSCXCY", "TH2D", &hSCXCY, 32000, 0 );
-        }
-        */
-        //NK
-        /*
-        if( !bSmallFile )
-        {
-            fTree->Branch( "hSZeAz", "TH2D", &hSZeAz, 32000, 0 );
-        }
-        */
-        //fTree->Branch( "hBunch", "TH1D", &hBunch, 32000, 0 );
-        fTree->Branch( "hZem", "TH1D", &hZem, 32000, 0 );
-        fTree->Branch( "hT0", "TH1D", &hT0, 32000, 0 );
-        
-        /*
-        if( !bSmallFile )
-        {
-            fTree->Branch( "hGXY", "TH2D", &hGXY, 32000, 0 );
-        }
-        */
-        //NK
-        /*
-        if( !bSmallFile )
+        // photon pairs within coincidence window per telescope pair (only pairs with coincidences)
+        fTree->Branch( "coincWindow", &coincWindow, "coincWindow/D" );
+        fTree->Branch( "coincMultiplicity", &coincMultiplicity, "coincMultiplicity/I" );
+        fTree->Branch( "coincTelA", &coincTelA, fBasketSize );
+        fTree->Branch( "coincTelB", &coincTelB, fBasketSize );
+        fTree->Branch( "coincNPairs", &coincNPairs, fBasketSize );
+    }
+    
+    // photon level data (pixels, photon directions, histograms): in the summary tree, or
+    // in a separate photon tree (one entry per summary tree entry; same eventNumber/arrayNumber)
+    fPhotonTree = fTree;
+    if( bSplitTrees )
+    {
+        fPhotonTree = 0;
+        if( bWritePhotonTree )
         {
-            fTree->Branch( "hGCXCY", "TH2D", &hGCXCY, 32000, 0 );
+            fPhotonTree = new TTree( "tphotons", "CORSIKA results (photon level)" );
+            if( fAutoFlush != 0 )
+            {
+                fPhotonTree->SetAutoFlush( fAutoFlush );
+            }
+            fPhotonTree->Branch( "eventNumber", &eventNumber, "eventNumber/I" );
+            fPhotonTree->Branch( "arrayNumber", &arrayNumber, "arrayNumber/I" );
         }
-        */
-        //NK
-        /*
-        if( !bSmallFile )
+    }
+    if( fPhotonTree )
+    {
+        if( fCamera )
         {
-            fTree->Branch( "hGZeAz", "TH2D", &hGZeAz, 32000, 0 );
+            // photons per pixel (sparse: only pixels with photons)
+            fPhotonTree->Branch( "pixTelID", &pixTelID, fBasketSize );
+            fPhotonTree->Branch( "pixID", &pixID, fBasketSize );
+            fPhotonTree->Branch( "pixNPhotons", &pixNPhotons, fBasketSize );
+            if( timeBinNumber > 0 )
+            {
+                // arrival time bin i covers [timeBinMin + i*timeBinWidth, timeBinMin + (i+1)*timeBinWidth[ ns
+                fPhotonTree->Branch( "timeBinWidth", &timeBinWidth, "timeBinWidth/D" );
+                fPhotonTree->Branch( "timeBinMin", &timeBinMin, "timeBinMin/D" );
+                fPhotonTree->Branch( "timeBinNumber", &timeBinNumber, "timeBinNumber/I" );
+                fPhotonTree->Branch( "ptTelID", &ptTelID, fBasketSize );
+                fPhotonTree->Branch( "ptPixID", &ptPixID, fBasketSize );
+                fPhotonTree->Branch( "ptTimeBin", &ptTimeBin, fBasketSize );
+                fPhotonTree->Branch( "ptNPhotons", &ptNPhotons, fBasketSize );
+            }
         }
-        */
-        if( !bSmallFile )
+        else
         {
-            fTree->Branch( "hGProb", "TH1D", &hGProb, 32000, 0 );
+            if( fPhotonPrecision == 1 )
+            {
+                fPhotonTree->Branch( "CX", &CXf, fBasketSize );
+                fPhotonTree->Branch( "CY", &CYf, fBasketSize );
+                fPhotonTree->Branch( "telID", &telIDs, fBasketSize );
+            }
+            else if( fPhotonPrecision == 2 )
+            {
+                // direction cosine = CX / CXYscale
+                fPhotonTree->Branch( "CXYscale", &CXYscale, "CXYscale/D" );
+                fPhotonTree->Branch( "CX", &CXs, fBasketSize );
+                fPhotonTree->Branch( "CY", &CYs, fBasketSize );
+                fPhotonTree->Branch( "telID", &telIDs, fBasketSize );
+            }
+            else
+            {
+                fPhotonTree->Branch( "CX", &CX, fBasketSize ); //NK
+                fPhotonTree->Branch( "CY", &CY, fBasketSize ); //NK
+                fPhotonTree->Branch( "telID", &telID, fBasketSize ); //NK
+            }
         }
-        if( !bSmallFile )
+        //fTree->Branch( "CTime", &CTime); //NK
+        //fTree->Branch("CXCY", CXCY, "CXCY", &CXCY );
+
+        if( !bShort )
         {
-            fTree->Branch( "hGZem", "TH1D", &hGZem, 32000, 0 );
-        }
+            /*
+            if( !bSmallFile )
+            {
+                fTree->Branch( "hGLambda", "TH1D", &hGLambda, fBasketSize, 0 );
+            }
+            */
+            fPhotonTree->Branch( "hSLambda", "TH1D", &hSLambda, fBasketSize, 0 );
+            //NK
+            /*
+            if( !bSmallFile )
+            {
+                fTree->Branch( "hSCXCY", "TH2D", &hSCXCY, fBasketSize, 0 );
+            }
+            */
+            //NK
+            /*
+            if( !bSmallFile )
+            {
+                fTree->Branch( "hSZeAz", "TH2D", &hSZeAz, fBasketSize, 0 );
+            }
+            */
+            //fTree->Branch( "hBunch", "TH1D", &hBunch, fBasketSize, 0 );
+            fPhotonTree->Branch( "hZem", "TH1D", &hZem, fBasketSize, 0 );
+            fPhotonTree->Branch( "hT0", "TH1D", &hT0, fBasketSize, 0 );
         
-        fTree->Branch( "hSXY", "TH2D", &hSXY, 32000, 0 );
-        if( !bSmallFile )
-        {
-            fTree->Branch( "hSProb", "TH1D", &hSProb, 32000, 0 );
+            /*
+            if( !bSmallFile )
+            {
+                fTree->Branch( "hGXY", "TH2D", &hGXY, fBasketSize, 0 );
+            }
+            */
+            //NK
+            /*
+            if( !bSmallFile )
+            {
+                fTree->Branch( "hGCXCY", "TH2D", &hGCXCY, fBasketSize, 0 );
+            }
+            */
+            //NK
+            /*
+            if( !bSmallFile )
+            {
+                fTree->Branch( "hGZeAz", "TH2D", &hGZeAz, fBasketSize, 0 );
+            }
+            */
+            if( !bSmallFile )
+            {
+                fPhotonTree->Branch( "hGProb", "TH1D", &hGProb, fBasketSize, 0 );
+            }
+            if( !bSmallFile )
+            {
+                fPhotonTree->Branch( "hGZem", "TH1D", &hGZem, fBasketSize, 0 );
+            }
+        
+            fPhotonTree->Branch( "hSXY", "TH2D", &hSXY, fBasketSize, 0 );
+            if( !bSmallFile )
+            {
+                fPhotonTree->Branch( "hSProb", "TH1D", &hSProb, fBasketSize, 0 );
+            }
+            fPhotonTree->Branch( "hSZem", "TH1D", &hSZem, fBasketSize, 0 );
         }
-        fTree->Branch( "hSZem", "TH1D", &hSZem, 32000, 0 );
     }
-    
 }
 
-void VIOHistograms::newEvent( float* evth, telescope_array array, int i_array )
+void VIOHistograms::newEvent( float* evth, const telescope_array& array, int i_array )
 {
-    if( nevent > 0 )
+    if( bEventPending )
     {
-        fTree->Fill();
-    }
-    
-    if( !bShort )
-    {
-        //hBunch->Reset();
-        hZem->Reset();
-        hT0->Reset();
-        
-        hSXY->Reset();
-        //hSCXCY->Reset(); //NK
-        //hSZeAz->Reset(); NK
-        hSProb->Reset();
-        hSLambda->Reset();
-        hSZem->Reset();
-        
-        //hGXY->Reset();
-        //hGCXCY->Reset(); //NK
-        //hGZeAz->Reset(); NK
-        hGProb->Reset();
-        //hGLambda->Reset();
-        hGZem->Reset();
-        
-        if( hCXYZ )
-        {
-            TH2D* it;
-            for( int i = 0; i <= hCXYZ->GetLast(); i++ )
-            {
-                if( ( it = ( TH2D* )hCXYZ->At( i ) ) )
-                {
-                    it->Reset();
-                }
-            }
-        }
+        flushHistograms();
+        fillTrees();
     }
     
     eventNumber = ( int )evth[1];
@@ -413,171 +506,438 @@ void VIOHistograms::newEvent( float* evth, telescope_array array, int i_array )
     // number of Cherenkov photons (sum over all telescopes)
     
     nevent++;
+    fNextPart = 0;
+    bEventPending = true;
 }
 
-void VIOHistograms::fillBunch( bunch i_bunch, double itime )
+/*!
+    run-level histograms: sums of the per-event 1D histograms over all
+    events written to the tree (same order as in flushHistograms())
+*/
+void VIOHistograms::initRunHistograms()
 {
-    if( !bShort )
+    VIOHistogramAccumulator* a = fEventAcc;
+    VFlatHistogram* iAcc[] = { a->fT0, a->fZem, a->fGLambda, a->fGProb, a->fGZem, a->fSLambda, a->fSProb, a->fSZem };
+    const char* iName[] = { "hRunT0", "hRunZem", "hRunGLambda", "hRunGProb", "hRunGZem", "hRunSLambda", "hRunSProb", "hRunSZem" };
+    const char* iTitle[] = { "Cherenkov bunch arrival times", "height of Cherenkov bunch emission",
+                             "Cherenkov photon wavelength (no absorption/efficencies applied)",
+                             "survival probability (no absorption/efficencies applied)",
+                             "Cherenkov photon emission height (no absorption/efficencies applied)",
+                             "Cherenkov photon wavelength (absorption/efficencies applied)",
+                             "survival probability (absorption/efficencies applied)",
+                             "Cherenkov photon emission height (absorption/efficencies applied)"
+                           };
+    const char* iXTitle[] = { "arrival time [ns]", "height [m]", "wavelength [nm]", "propability", "height [m]",
+                              "wavelength [nm]", "propability", "height [m]"
+                            };
+    for( unsigned int i = 0; i < sizeof( iAcc ) / sizeof( iAcc[0] ); i++ )
     {
-        //hBunch->Fill( i_bunch.photons );
-        hT0->Fill( itime );
-        hZem->Fill( i_bunch.zem * 0.01 );
+        if( !iAcc[i] )
+        {
+            return;
+        }
+        fRunSum.push_back( new VFlatHistogram( iAcc[i]->getNbinsX(), iAcc[i]->getXmin(), iAcc[i]->getXmax() ) );
+        char htitle[400];
+        sprintf( htitle, "%s (sum over all events)", iTitle[i] );
+        hRun.push_back( new TH1D( iName[i], htitle, iAcc[i]->getNbinsX(), iAcc[i]->getXmin(), iAcc[i]->getXmax() ) );
+        hRun.back()->SetXTitle( iXTitle[i] );
+        hRun.back()->SetDirectory( 0 );
+    }
+}
+
+void VIOHistograms::fillTrees()
+{
+    fTree->Fill();
+    if( fPhotonTree && fPhotonTree != fTree )
+    {
+        fPhotonTree->Fill();
     }
 }
 
+/*!
+    drop the current event (e.g. event did not trigger)
+*/
+void VIOHistograms::discardEvent()
+{
+    fEventAcc->reset();
+    bEventPending = false;
+}
+
+void VIOHistograms::fillBunch( const bunch& i_bunch, double itime )
+{
+    fEventAcc->fillBunch( i_bunch, itime );
+}
+
+/*!
+    expected numbers of generated and detected photons (counts-only mode; see VIOHistogramAccumulator::fillExpected)
+*/
+void VIOHistograms::fillExpected( double iZem, double iLambda, double iGenerated, double iDetected )
+{
+    fEventAcc->fillExpected( iZem, iLambda, iGenerated, iDetected );
+}
+
 /*!
     in corsika coordinates
 */
-void VIOHistograms::fillGenerated( bunch ph, double prob )
+void VIOHistograms::fillGenerated( const bunch& ph, double prob )
 {
-    if( !bShort )
+    fEventAcc->fillGenerated( ph, prob );
+}
+
+void VIOHistograms::fillSurvived( const bunch& ph, double prob, float* evth, int iTel )
+{
+    fEventAcc->fillSurvived( ph, prob, iTel );
+}
+
+/*!
+    fill n surviving photons of telescope iTel
+*/
+void VIOHistograms::fillSurvivedN( int n, const bunch* ph, const double* prob, int iTel )
+{
+    for( int i = 0; i < n; i++ )
     {
-        double az = 0.;
-        double ze = 0.;
-        az = atan2( ph.cy, ph.cx );
-        az = redang( az );
+        fEventAcc->fillSurvived( ph[i], prob[i], iTel );
+    }
+}
 
-        if( ph.cy != 0. )
-        {
-            ze = asin( ph.cy / sin( az ) );
-        }
-        else
-        {
-            ze = asin( ph.cy / cos( az ) );
-        }
-        ze *= degrad;
-        az *= degrad;
-        if( az < 0 )
+void VIOHistograms::fillNPhotons( int iTel, double iphotons )
+{
+    //NCp[iTel] = iphotons; adjusted by NK (fill survived photons rather than generated)
+    if( iTel < telNumber )
+    {
+        fEventAcc->fillNPhotons( iTel, iphotons );
+    }
+}
+
+/*!
+    new (empty) accumulator with the configuration of this histogram class
+
+    to be filled by a worker, tagged with setOrder() and handed back with commit()
+*/
+VIOHistogramAccumulator* VIOHistograms::newAccumulator()
+{
+    VIOHistogramAccumulator* iAcc = new VIOHistogramAccumulator( *fEventAcc );
+    iAcc->reset();
+    return iAcc;
+}
+
+/*!
+    add the contents of a worker accumulator to the current event
+
+    the accumulator must be tagged with the current event and the next part
+    of this event (parts 0, 1, 2, ... in the order of a serial run); commits
+    out of order are rejected, so that the tree is the same as in serial
+    processing. The accumulator is reset (and untagged) and can be reused.
+
+    \return false if the accumulator was rejected
+*/
+bool VIOHistograms::commit( VIOHistogramAccumulator* iAcc )
+{
+    if( !iAcc || iAcc == fEventAcc )
+    {
+        return false;
+    }
+    if( iAcc->fEvent != getEventIndex() || iAcc->fPart != fNextPart )
+    {
+        cout << "VIOHistograms::commit error: accumulator out of order (event " << iAcc->fEvent;
+        cout << ", part " << iAcc->fPart << "; expected event " << getEventIndex() << ", part " << fNextPart << ")" << endl;
+        return false;
+    }
+    fEventAcc->add( *iAcc );
+    iAcc->reset();
+    fNextPart++;
+    return true;
+}
+
+void VIOHistograms::terminate()
+{
+    if( fTree && bEventPending )
+    {
+        flushHistograms();
+        fillTrees();    // write last event
+    }
+    
+    if( fout )
+    {
+        fout->cd();
+        cout << "writing results (cherenkov histograms) in file: " << fout->GetName() << endl;
+        fTree->Write();
+        for( unsigned int i = 0; i < hRun.size() && i < fRunSum.size(); i++ )
         {
-            az = 360. - az;
+            fRunSum[i]->copyTo( hRun[i] );
+            hRun[i]->Write();
         }
-        /*
-        if( !bCORSIKA_coordinates )
+        if( fPhotonTree && fPhotonTree != fTree )
         {
-            hGXY->Fill( ph.x, ph.y );
+            fPhotonTree->BuildIndex( "eventNumber", "arrayNumber" );
+            fPhotonTree->Write();
         }
-        else
+        
+        // write all histograms outside of tree if there is only one event in the tree
+        if( fTree->GetEntries() == 1 )
         {
-            hGXY->Fill( ph.y, -ph.x );
+            hisList->Write();
         }
-        */
-        //hGCXCY->Fill( ph.cx*degrad, ph.cy*degrad); //NK
-        //hGZeAz->Fill( ze, az ); NK
-        hGProb->Fill( prob );
-        //hGLambda->Fill( ph.lambda );
-        hGZem->Fill( ph.zem );
+        fout->Close();
+    }
+    else
+    {
+        cout << "VIOHistograms::terminate() error writing to output file" << endl;
+        cout << endl;
     }
 }
 
-void VIOHistograms::fillSurvived( bunch ph, double prob, float* evth, int iTel )
+/*!
+    storage type of the photon direction branches CX, CY (and telID)
+
+    \param iPrecision  double (default), float (float CX/CY, short telID), or
+                       int16 (fixed point CX/CY * 30000 as in compact_bunch, short telID)
+*/
+bool VIOHistograms::setPhotonPrecision( string iPrecision )
 {
-    if( !bShort )
+    if( iPrecision == "double" )
+    {
+        fPhotonPrecision = 0;
+        CXYscale = 1.;
+    }
+    else if( iPrecision == "float" )
+    {
+        fPhotonPrecision = 1;
+        CXYscale = 1.;
+    }
+    else if( iPrecision == "int16" )
     {
-        double az = 0.;
-        double ze = 0.;
+        fPhotonPrecision = 2;
+        CXYscale = 30000.;
+    }
+    else
+    {
+        cout << "VIOHistograms::setPhotonPrecision error: unknown precision " << iPrecision << " (allowed: double, float, int16)" << endl;
+        return false;
+    }
+    return true;
+}
 
-        az = atan2( ph.cy, ph.cx );
-        az = redang( az );
+/*!
+    compression of the ROOT output file
 
-        if( ph.cy != 0. )
-        {
-            ze = asin( ph.cy / sin( az ) );
-        }
-        else
+    \param iSetting  ALGORITHM[:LEVEL] with ALGORITHM zlib, lzma, lz4, zstd (or a level 0-9 only)
+*/
+bool VIOHistograms::setCompression( string iSetting )
+{
+    string iAlgo = iSetting;
+    string iLevel = "";
+    if( iSetting.find( ":" ) != string::npos )
+    {
+        iAlgo = iSetting.substr( 0, iSetting.find( ":" ) );
+        iLevel = iSetting.substr( iSetting.find( ":" ) + 1 );
+    }
+    else if( iSetting.size() > 0 && isdigit( iSetting[0] ) )
+    {
+        iAlgo = "";
+        iLevel = iSetting;
+    }
+    if( iAlgo == "zlib" )
+    {
+        fCompressionAlgorithm = ROOT::kZLIB;
+    }
+    else if( iAlgo == "lzma" )
+    {
+        fCompressionAlgorithm = ROOT::kLZMA;
+    }
+    else if( iAlgo == "lz4" )
+    {
+        fCompressionAlgorithm = ROOT::kLZ4;
+    }
+    else if( iAlgo == "zstd" )
+    {
+        fCompressionAlgorithm = ROOT::kZSTD;
+    }
+    else if( iAlgo.size() > 0 )
+    {
+        cout << "VIOHistograms::setCompression error: unknown compression algorithm " << iAlgo << endl;
+        return false;
+    }
+    if( iLevel.size() > 0 )
+    {
+        fCompressionLevel = atoi( iLevel.c_str() );
+        if( fCompressionLevel < 0 || fCompressionLevel > 9 )
         {
-            ze = asin( ph.cy / cos( az ) );
+            cout << "VIOHistograms::setCompression error: compression level out of range (0-9): " << iLevel << endl;
+            return false;
         }
-        ze *= degrad;
-        az *= degrad;
-        if( az < 0 )
+    }
+    return true;
+}
+
+/*!
+    photon arrival time coincidences between telescopes
+
+    \param iWindow  coincidence window [ns]
+*/
+void VIOHistograms::setCoincidenceWindow( double iWindow )
+{
+    if( iWindow <= 0. )
+    {
+        cout << "VIOHistograms::setCoincidenceWindow error: invalid coincidence window " << iWindow << " ns" << endl;
+        exit( -1 );
+    }
+    coincWindow = iWindow;
+    if( !fCoincidence )
+    {
+        fCoincidence = new VTelescopeCoincidence();
+    }
+    fCoincidence->setWindow( coincWindow );
+}
+
+/*!
+    arrival time histograms per pixel (requires a camera layout)
+
+    \param iWidth  time bin width [ns]
+    \param iTMin   start of time window [ns]
+    \param iTMax   end of time window [ns]
+*/
+void VIOHistograms::setTimeBinning( double iWidth, double iTMin, double iTMax )
+{
+    if( iWidth <= 0. || iTMax <= iTMin )
+    {
+        cout << "VIOHistograms::setTimeBinning error: invalid time binning (width " << iWidth;
+        cout << " ns, window " << iTMin << " to " << iTMax << " ns)" << endl;
+        exit( -1 );
+    }
+    timeBinWidth = iWidth;
+    timeBinMin = iTMin;
+    timeBinNumber = ( int )ceil( ( iTMax - iTMin ) / iWidth );
+}
+
+/*!
+    copy the accumulated photons of the current event into the tree histograms
+    and reset the accumulators
+*/
+void VIOHistograms::flushHistograms()
+{
+    if( !fEventAcc )
+    {
+        return;
+    }
+    for( int i = 0; i < telNumber; i++ )
+    {
+        NCp[i] = ( i < ( int )fEventAcc->fNCp.size() ? fEventAcc->fNCp[i] : 0. );
+    }
+    CX.swap( fEventAcc->fCX );
+    CY.swap( fEventAcc->fCY );
+    telID.swap( fEventAcc->fTelID );
+    if( fPhotonPrecision > 0 )
+    {
+        CXf.clear();
+        CYf.clear();
+        CXs.clear();
+        CYs.clear();
+        telIDs.assign( telID.begin(), telID.end() );
+        if( fPhotonPrecision == 1 )
         {
-            az = 360. - az;
-        }
-        
-        if( !bCORSIKA_coordinates )
-        {   
-            hSXY->Fill( ph.x, ph.y);
+            CXf.assign( CX.begin(), CX.end() );
+            CYf.assign( CY.begin(), CY.end() );
         }
         else
         {
-            hSXY->Fill( ph.y, -ph.x);
+            CXs.resize( CX.size() );
+            CYs.resize( CY.size() );
+            for( unsigned int i = 0; i < CX.size(); i++ )
+            {
+                CXs[i] = ( short )Nint( CX[i] * CXYscale );
+                CYs[i] = ( short )Nint( CY[i] * CXYscale );
+            }
         }
-  
-        CX.push_back({ph.cx}); // NK
-        CY.push_back({ph.cy}); // NK
-        //CTime.push_back({ph.ctime}); // NK
-        telID.push_back({iTel+1});
-
-        hSProb->Fill( prob );
-        hSLambda->Fill( ph.lambda );
-        hSZem->Fill( ph.zem );
-        if( !hCXYZ )
+    }
+    
+    pixTelID.clear();
+    pixID.clear();
+    pixNPhotons.clear();
+    if( fCamera )
+    {
+        vector< int >& iFilled = fEventAcc->fPixelFilled;
+        sort( iFilled.begin(), iFilled.end() );
+        int npix = fCamera->getNPixels();
+        for( unsigned int i = 0; i < iFilled.size(); i++ )
         {
-            return;
+            pixTelID.push_back( iFilled[i] / npix + 1 );
+            pixID.push_back( iFilled[i] % npix );
+            pixNPhotons.push_back( fEventAcc->fPixelCounts[iFilled[i]] );
         }
         
-        // fill xyz histograms
-        double xp, yp;
-        TH2D* it;
-        for( unsigned int i = 0; i < fXYZlevelsHeight.size(); i++ )
+        ptTelID.clear();
+        ptPixID.clear();
+        ptTimeBin.clear();
+        ptNPhotons.clear();
+        if( timeBinNumber > 0 )
         {
-            if( fXYZlevelsHeight[i] > ph.zem )
+            vector< pair< long long, int > > iT( fEventAcc->fTimeCounts.begin(), fEventAcc->fTimeCounts.end() );
+            sort( iT.begin(), iT.end() );
+            for( unsigned int i = 0; i < iT.size(); i++ )
             {
-                continue;
-            }
-            xp = ph.x + fXYZlevelsHeight[i] * ph.cx;
-            yp = ph.y + fXYZlevelsHeight[i] * ph.cy;
-            
-            it = ( TH2D* )hCXYZ->At( i );
-            if( it )
-            {
-                if( !bCORSIKA_coordinates )
-                {
-                    it->Fill( xp, yp );
-                }
-                else
-                {
-                    it->Fill( yp, -xp );
-                }
+                long long iPixelIndex = iT[i].first / timeBinNumber;
+                ptTelID.push_back( ( int )( iPixelIndex / npix ) + 1 );
+                ptPixID.push_back( ( int )( iPixelIndex % npix ) );
+                ptTimeBin.push_back( ( int )( iT[i].first % timeBinNumber ) );
+                ptNPhotons.push_back( iT[i].second );
             }
         }
-        
     }
-}
-
-void VIOHistograms::fillNPhotons( int iTel, double iphotons)
-{
-    if( iTel < telNumber )
-    {
-        NCp[iTel] += iphotons; //NCp[iTel] = iphotons; adjusted by NK (fill survived photons rather than generated)
-    }
-}
-
-void VIOHistograms::terminate()
-{
-    if( fTree )
+    
+    coincMultiplicity = 0;
+    coincTelA.clear();
+    coincTelB.clear();
+    coincNPairs.clear();
+    if( fCoincidence )
     {
-        fTree->Fill();    // write last event
+        fCoincidence->clear();
+        for( unsigned int i = 0; i < fEventAcc->fArrivalTel.size(); i++ )
+        {
+            fCoincidence->fill( fEventAcc->fArrivalTel[i], fEventAcc->fArrivalTime[i] );
+        }
+        fCoincidence->evaluate();
+        coincMultiplicity = fCoincidence->getMultiplicity();
+        for( unsigned int i = 0; i < fCoincidence->getTelA().size(); i++ )
+        {
+            coincTelA.push_back( fCoincidence->getTelA()[i] + 1 );
+            coincTelB.push_back( fCoincidence->getTelB()[i] + 1 );
+        }
+        coincNPairs = fCoincidence->getNPairs();
     }
     
-    if( fout )
+    // run-level sums
+    VIOHistogramAccumulator* iE = fEventAcc;
+    VFlatHistogram* iRunAcc[] = { iE->fT0, iE->fZem, iE->fGLambda, iE->fGProb, iE->fGZem, iE->fSLambda, iE->fSProb, iE->fSZem };
+    for( unsigned int i = 0; i < fRunSum.size() && i < sizeof( iRunAcc ) / sizeof( iRunAcc[0] ); i++ )
     {
-        fout->cd();
-        cout << "writing results (cherenkov histograms) in file: " << fout->GetName() << endl;
-        fTree->Write();
-        
-        // write all histograms outside of tree if there is only one event in the tree
-        if( fTree->GetEntries() == 1 )
+        if( iRunAcc[i] )
         {
-            hisList->Write();
+            fRunSum[i]->add( *iRunAcc[i] );
         }
-        fout->Close();
     }
-    else
+    
+    if( !bShort )
     {
-        cout << "VIOHistograms::terminate() error writing to output file" << endl;
-        cout << endl;
+        VIOHistogramAccumulator* a = fEventAcc;
+        VFlatHistogram* iAcc[] = { a->fT0, a->fZem, a->fGProb, a->fGZem, a->fSXY, a->fSLambda, a->fSProb, a->fSZem };
+        TH1* iHis[] = { hT0, hZem, hGProb, hGZem, hSXY, hSLambda, hSProb, hSZem };
+        for( unsigned int i = 0; i < sizeof( iAcc ) / sizeof( iAcc[0] ); i++ )
+        {
+            if( iAcc[i] && iHis[i] )
+            {
+                iAcc[i]->copyTo( iHis[i] );
+            }
+        }
+        if( hCXYZ )
+        {
+            for( unsigned int i = 0; i < a->fCXYZ.size(); i++ )
+            {
+                a->fCXYZ[i]->copyTo( ( TH2D* )hCXYZ->At( i ) );
+            }
+        }
     }
+    fEventAcc->reset();
 }
 
 //! reduce large angle to intervall 0, 2*pi
@@ -668,8 +1028,12 @@ void VIOHistograms::initXYZhistograms()
         iT->SetXTitle( "x [m] (north)" );
         iT->SetYTitle( "y [m] (west)" );
     }
+    fEventAcc->initXYZhistograms( fXYZlevelsHeight, xybin, xmax, ymax );
     
-    fTree->Branch( "hCXYZ", &hCXYZ, 256000, 0 );
+    if( fPhotonTree )
+    {
+        fPhotonTree->Branch( "hCXYZ", &hCXYZ, 8 * fBasketSize, 0 );
+    }
 }
 
 
@@ -0,0 +1,175 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VPerfCounters
+    \brief hardware performance counters (Linux perf_event_open)
+
+    Counts cycles, instructions, cache misses and branch misses of this
+    process (user space only, works with perf_event_paranoid <= 2).
+    All counters are read at once (counter group); values are scaled
+    for multiplexing (time enabled / time running).
+
+    Counters which cannot be opened (no permission, not supported by
+    the CPU or virtual machine, or no Linux) are marked as not available;
+    getStatus() gives the reason.
+*/
+
+#include "VPerfCounters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+VPerfCounters::VPerfCounters()
+{
+    fGroupFD = -1;
+    for( int i = 0; i < N_COUNTERS; i++ )
+    {
+        fFD[i] = -1;
+        fIndex[i] = -1;
+    }
+    fNOpen = 0;
+    fStatus = "not opened";
+}
+
+VPerfCounters::~VPerfCounters()
+{
+    close();
+}
+
+const char* VPerfCounters::getCounterName( int iCounter )
+{
+    static const char* iName[] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+    if( iCounter < 0 || iCounter >= N_COUNTERS )
+    {
+        return "unknown";
+    }
+    return iName[iCounter];
+}
+
+/*!
+    open all counters (returns false if no counter is available)
+*/
+bool VPerfCounters::open()
+{
+    close();
+#ifdef __linux__
+    unsigned long long iConfig[] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                     PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+                                   };
+    string iErrors = "";
+    for( int i = 0; i < N_COUNTERS; i++ )
+    {
+        struct perf_event_attr pe;
+        memset( &pe, 0, sizeof( pe ) );
+        pe.type = PERF_TYPE_HARDWARE;
+        pe.size = sizeof( pe );
+        pe.config = iConfig[i];
+        pe.disabled = ( fGroupFD < 0 ? 1 : 0 );
+        pe.exclude_kernel = 1;
+        pe.exclude_hv = 1;
+        pe.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = ( int )syscall( __NR_perf_event_open, &pe, 0, -1, fGroupFD, 0 );
+        if( fd < 0 )
+        {
+            if( iErrors.size() > 0 )
+            {
+                iErrors += ", ";
+            }
+            iErrors += string( getCounterName( i ) ) + ": " + strerror( errno );
+            continue;
+        }
+        if( fGroupFD < 0 )
+        {
+            fGroupFD = fd;
+        }
+        fFD[i] = fd;
+        fIndex[i] = fNOpen;
+        fNOpen++;
+    }
+    if( fNOpen == 0 )
+    {
+        fStatus = "not available (" + iErrors + ")";
+        return false;
+    }
+    ioctl( fGroupFD, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+    ioctl( fGroupFD, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+    fStatus = ( iErrors.size() > 0 ? "partially available (" + iErrors + ")" : "available" );
+    return true;
+#else
+    fStatus = "not available (perf_event_open requires Linux)";
+    return false;
+#endif
+}
+
+void VPerfCounters::close()
+{
+#ifdef __linux__
+    for( int i = 0; i < N_COUNTERS; i++ )
+    {
+        if( fFD[i] >= 0 )
+        {
+            ::close( fFD[i] );
+        }
+        fFD[i] = -1;
+        fIndex[i] = -1;
+    }
+#endif
+    fGroupFD = -1;
+    fNOpen = 0;
+}
+
+/*!
+    current counter values (iValues: N_COUNTERS values; 0 for counters not available)
+*/
+bool VPerfCounters::read( double* iValues )
+{
+    for( int i = 0; i < N_COUNTERS; i++ )
+    {
+        iValues[i] = 0.;
+    }
+#ifdef __linux__
+    if( fGroupFD < 0 )
+    {
+        return false;
+    }
+    // nr, time enabled, time running, values
+    unsigned long long iBuffer[3 + N_COUNTERS];
+    if( ::read( fGroupFD, iBuffer, sizeof( iBuffer ) ) < ( ssize_t )( ( 3 + fNOpen ) * sizeof( unsigned long long ) ) )
+    {
+        return false;
+    }
+    double iScale = ( iBuffer[2] > 0 ? ( double )iBuffer[1] / ( double )iBuffer[2] : 1. );
+    for( int i = 0; i < N_COUNTERS; i++ )
+    {
+        if( fIndex[i] >= 0 )
+        {
+            iValues[i] = iBuffer[3 + fIndex[i]] * iScale;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,112 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VPixelTrigger
+    \brief pixel threshold trigger in a coincidence window
+
+    A telescope triggers if at least fThreshold photons arrive in one
+    of its camera pixels within fWindow ns. The event triggers if at
+    least fMinTelescopes telescopes trigger.
+
+    Photons are mapped onto pixels with the camera layout (see
+    VCameraLayout); photons outside the camera are ignored.
+*/
+
+#include "VPixelTrigger.h"
+
+VPixelTrigger::VPixelTrigger( const VCameraLayout* iCamera, int iThreshold, double iWindow, int iMinTelescopes )
+{
+    fCamera = iCamera;
+    fThreshold = ( iThreshold > 0 ? iThreshold : 1 );
+    fWindow = ( iWindow > 0. ? iWindow : 0. );
+    fMinTelescopes = ( iMinTelescopes > 0 ? iMinTelescopes : 1 );
+}
+
+void VPixelTrigger::reset()
+{
+    fPhotons.clear();
+    fTriggeredTel.clear();
+}
+
+/*!
+    photon arriving in telescope iTel (counting from 0)
+*/
+void VPixelTrigger::fill( int iTel, const bunch& ph )
+{
+    if( !fCamera || iTel < 0 )
+    {
+        return;
+    }
+    int iPixel = fCamera->getPixel( iTel, ph.cx, ph.cy );
+    if( iPixel >= 0 )
+    {
+        fPhotons.push_back( make_pair( ( long long )iTel * fCamera->getNPixels() + iPixel, ( double )ph.ctime ) );
+    }
+}
+
+/*!
+    sliding coincidence window over the time ordered photons of each pixel
+
+    fills the list of triggered telescopes (counting from 0)
+*/
+bool VPixelTrigger::isTriggered()
+{
+    fTriggeredTel.clear();
+    if( ( int )fPhotons.size() < fThreshold * fMinTelescopes )
+    {
+        return false;
+    }
+    sort( fPhotons.begin(), fPhotons.end() );
+
+    int npix = fCamera->getNPixels();
+    unsigned int iStart = 0;
+    for( unsigned int i = 0; i < fPhotons.size(); i++ )
+    {
+        // first photon of this pixel within the coincidence window
+        if( fPhotons[iStart].first != fPhotons[i].first )
+        {
+            iStart = i;
+        }
+        while( fPhotons[i].second - fPhotons[iStart].second > fWindow )
+        {
+            iStart++;
+        }
+        if( ( int )( i - iStart + 1 ) >= fThreshold )
+        {
+            int iTel = ( int )( fPhotons[i].first / npix );
+            if( fTriggeredTel.size() == 0 || fTriggeredTel.back() != iTel )
+            {
+                fTriggeredTel.push_back( iTel );
+            }
+            // skip remaining photons of this telescope
+            long long iNextTel = ( long long )( iTel + 1 ) * npix;
+            while( i + 1 < fPhotons.size() && fPhotons[i + 1].first < iNextTel )
+            {
+                i++;
+            }
+            iStart = i + 1;
+        }
+    }
+    return ( ( int )fTriggeredTel.size() >= fMinTelescopes );
+}
+
+void VPixelTrigger::print() const
+{
+    cout << "pixel trigger: " << fThreshold << " photons per pixel in " << fWindow << " ns";
+    cout << ", at least " << fMinTelescopes << " telescope(s)" << endl;
+}
@@ -0,0 +1,297 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VProgressReporter
+    \brief periodic progress and throughput report of a run (-progress)
+
+    A separate thread reports every fInterval seconds the bytes read of
+    the total input file size, events and photons processed (with
+    average rates and rates over the last interval) and the estimated
+    time to completion. The main thread only hands over its counters
+    with update().
+
+    Reports are written as one line to stderr, or (with a status file)
+    as a JSON object replacing the status file (written to FILE.tmp and
+    renamed, so readers never see a partial file). A final report is
+    written by stop().
+*/
+
+#include "VProgressReporter.h"
+#include "VRunStatistics.h"
+
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include <sys/time.h>
+
+/*!
+    wall clock time [s]
+*/
+static double getWallTime()
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.e-6 * tv.tv_usec;
+}
+
+VProgressReporter::VProgressReporter( double iInterval, string iStatusFile )
+{
+    fInterval = ( iInterval > 0. ? iInterval : 60. );
+    fStatusFile = iStatusFile;
+    fTotalBytes = 0;
+    fEventLimit = -1;
+    fStartTime = getWallTime();
+    fBytes = 0;
+    fEvents = 0;
+    fPhotons = 0.;
+    fLastTime = fStartTime;
+    fLastBytes = 0;
+    fLastEvents = 0;
+    fLastPhotons = 0.;
+    bRunning = false;
+    bStop = false;
+    pthread_mutex_init( &fMutex, NULL );
+    pthread_cond_init( &fCondition, NULL );
+}
+
+VProgressReporter::~VProgressReporter()
+{
+    stop();
+    pthread_cond_destroy( &fCondition );
+    pthread_mutex_destroy( &fMutex );
+}
+
+/*!
+    input file name and size [bytes] (0: unknown, e.g. pipe); optional limit on the number of events
+*/
+void VProgressReporter::setInput( string iInputFile, long long iTotalBytes, int iEventLimit )
+{
+    fInputFile = iInputFile;
+    fTotalBytes = iTotalBytes;
+    fEventLimit = iEventLimit;
+}
+
+bool VProgressReporter::start()
+{
+    if( bRunning )
+    {
+        return true;
+    }
+    fStartTime = getWallTime();
+    fLastTime = fStartTime;
+    bStop = false;
+    if( pthread_create( &fThread, NULL, VProgressReporter::run, this ) != 0 )
+    {
+        cerr << "VProgressReporter: error starting progress thread; no progress reports" << endl;
+        return false;
+    }
+    bRunning = true;
+    return true;
+}
+
+/*!
+    stop reporter thread and write final report
+*/
+void VProgressReporter::stop()
+{
+    if( !bRunning )
+    {
+        return;
+    }
+    pthread_mutex_lock( &fMutex );
+    bStop = true;
+    pthread_cond_signal( &fCondition );
+    pthread_mutex_unlock( &fMutex );
+    pthread_join( fThread, NULL );
+    bRunning = false;
+    report( true );
+}
+
+/*!
+    progress of the main thread (bytes read, events and photons processed)
+*/
+void VProgressReporter::update( long long iBytes, int iEvents, double iPhotons )
+{
+    pthread_mutex_lock( &fMutex );
+    fBytes = iBytes;
+    fEvents = iEvents;
+    fPhotons = iPhotons;
+    pthread_mutex_unlock( &fMutex );
+}
+
+void* VProgressReporter::run( void* iReporter )
+{
+    VProgressReporter* r = ( VProgressReporter* )iReporter;
+    pthread_mutex_lock( &r->fMutex );
+    while( !r->bStop )
+    {
+        double t_next = getWallTime() + r->fInterval;
+        struct timespec ts;
+        ts.tv_sec = ( time_t )t_next;
+        ts.tv_nsec = ( long )( ( t_next - ( double )ts.tv_sec ) * 1.e9 );
+        while( !r->bStop && pthread_cond_timedwait( &r->fCondition, &r->fMutex, &ts ) == 0 )
+        {
+            // spurious wake-up: wait again
+        }
+        if( r->bStop )
+        {
+            break;
+        }
+        pthread_mutex_unlock( &r->fMutex );
+        r->report( false );
+        pthread_mutex_lock( &r->fMutex );
+    }
+    pthread_mutex_unlock( &r->fMutex );
+    return NULL;
+}
+
+string VProgressReporter::formatBytes( double iBytes )
+{
+    const char* iUnit[] = { "B", "kB", "MB", "GB", "TB" };
+    unsigned int u = 0;
+    while( iBytes >= 1000. && u < 4 )
+    {
+        iBytes /= 1000.;
+        u++;
+    }
+    ostringstream os;
+    os.setf( ios::fixed );
+    os.precision( u == 0 ? 0 : 1 );
+    os << iBytes << " " << iUnit[u];
+    return os.str();
+}
+
+string VProgressReporter::formatTime( double iSeconds )
+{
+    if( iSeconds < 0. )
+    {
+        return "unknown";
+    }
+    long s = ( long )( iSeconds + 0.5 );
+    char c[100];
+    sprintf( c, "%02ld:%02ld:%02ld", s / 3600, ( s / 60 ) % 60, s % 60 );
+    return string( c );
+}
+
+void VProgressReporter::report( bool iFinal )
+{
+    pthread_mutex_lock( &fMutex );
+    long long iBytes = fBytes;
+    int iEvents = fEvents;
+    double iPhotons = fPhotons;
+    pthread_mutex_unlock( &fMutex );
+
+    double t_now = getWallTime();
+    double iElapsed = t_now - fStartTime;
+    double iInterval = t_now - fLastTime;
+
+    // fraction done (bytes of total file size, or events of event limit)
+    double iFraction = -1.;
+    if( fTotalBytes > 0 )
+    {
+        iFraction = ( double )iBytes / ( double )fTotalBytes;
+    }
+    if( fEventLimit > 0 && ( double )iEvents / ( double )fEventLimit > iFraction )
+    {
+        iFraction = ( double )iEvents / ( double )fEventLimit;
+    }
+    if( iFinal )
+    {
+        iFraction = 1.;
+    }
+    if( iFraction > 1. )
+    {
+        iFraction = 1.;
+    }
+    double iETA = -1.;
+    if( iFraction > 0. )
+    {
+        iETA = iElapsed * ( 1. - iFraction ) / iFraction;
+    }
+    double iBytesRate = ( iElapsed > 0. ? iBytes / iElapsed : 0. );
+    double iEventRate = ( iElapsed > 0. ? iEvents / iElapsed : 0. );
+    double iPhotonRate = ( iElapsed > 0. ? iPhotons / iElapsed : 0. );
+    double iCurrentBytesRate = ( iInterval > 0. ? ( iBytes - fLastBytes ) / iInterval : 0. );
+    double iCurrentEventRate = ( iInterval > 0. ? ( iEvents - fLastEvents ) / iInterval : 0. );
+    double iCurrentPhotonRate = ( iInterval > 0. ? ( iPhotons - fLastPhotons ) / iInterval : 0. );
+    fLastTime = t_now;
+    fLastBytes = iBytes;
+    fLastEvents = iEvents;
+    fLastPhotons = iPhotons;
+
+    // status file (JSON)
+    if( fStatusFile.size() > 0 )
+    {
+        string iTmpFile = fStatusFile + ".tmp";
+        ofstream os( iTmpFile.c_str() );
+        if( !os )
+        {
+            return;
+        }
+        os.precision( 6 );
+        os << "{" << endl;
+        os << "  \"input\": \"" << VRunStatistics::escapeJSON( fInputFile ) << "\"," << endl;
+        os << "  \"state\": \"" << ( iFinal ? "done" : "running" ) << "\"," << endl;
+        os << "  \"updated\": " << ( long )t_now << "," << endl;
+        os << "  \"elapsed_s\": " << iElapsed << "," << endl;
+        os << "  \"bytes\": " << iBytes << "," << endl;
+        os << "  \"total_bytes\": " << fTotalBytes << "," << endl;
+        os << "  \"fraction\": " << iFraction << "," << endl;
+        os << "  \"events\": " << iEvents << "," << endl;
+        os << "  \"photons\": " << iPhotons << "," << endl;
+        os << "  \"bytes_per_s\": " << iBytesRate << "," << endl;
+        os << "  \"events_per_s\": " << iEventRate << "," << endl;
+        os << "  \"photons_per_s\": " << iPhotonRate << "," << endl;
+        os << "  \"current_bytes_per_s\": " << iCurrentBytesRate << "," << endl;
+        os << "  \"current_events_per_s\": " << iCurrentEventRate << "," << endl;
+        os << "  \"current_photons_per_s\": " << iCurrentPhotonRate << "," << endl;
+        os << "  \"eta_s\": " << iETA << endl;
+        os << "}" << endl;
+        os.close();
+        rename( iTmpFile.c_str(), fStatusFile.c_str() );
+        return;
+    }
+
+    // one line to stderr
+    ostringstream os;
+    os << "progress: " << formatBytes( iBytes );
+    if( fTotalBytes > 0 )
+    {
+        os << " / " << formatBytes( fTotalBytes );
+    }
+    if( iFraction >= 0. )
+    {
+        os.setf( ios::fixed );
+        os.precision( 1 );
+        os << " (" << 100. * iFraction << "%)";
+        os.unsetf( ios::fixed );
+    }
+    // rates over the last interval (final report: average rates)
+    os.precision( 3 );
+    os << ", " << formatBytes( iFinal ? iBytesRate : iCurrentBytesRate ) << "/s";
+    os << ", " << iEvents << " events (" << ( iFinal ? iEventRate : iCurrentEventRate ) << "/s)";
+    os << ", " << iPhotons << " photons (" << ( iFinal ? iPhotonRate : iCurrentPhotonRate ) << "/s)";
+    os << ", elapsed " << formatTime( iElapsed );
+    if( !iFinal )
+    {
+        os << ", ETA " << formatTime( iETA );
+    }
+    cerr << os.str() << endl;
+}
@@ -0,0 +1,282 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VRunStatistics
+    \brief per-stage timers and counters of the main loop (-stats)
+
+    Stages are timed with a monotonic clock (VStageTimer). Per-photon
+    stages (extinction, QE/lens sampling) are timed for every
+    fPhotonSampling-th photon only and scaled accordingly; all other
+    stages are timed for each call. The photon loop stage contains the
+    extinction, QE/lens and per-photon histogram filling stages and is
+    not included in the sum of stages.
+
+    Optionally, hardware counters (VPerfCounters) are read at the start
+    and stop of the stage timers, except for the per-bunch and per-photon
+    timers (extinction and QE/lens stages have no counters; counters of
+    the histogram filling stage cover the per-telescope fills only).
+
+    The report (JSON) lists time per stage, the remainder of the wall
+    time not covered by any stage ("other"), blocks by type, bytes,
+    bunches, generated and surviving photons and read/skipped telescopes.
+*/
+
+#include "VRunStatistics.h"
+
+#include "initial.h"
+#include "io_basic.h"
+#include "mc_tel.h"
+
+#include <cstdio>
+#include <sys/resource.h>
+
+VRunStatistics::VRunStatistics( int iPhotonSampling )
+{
+    // calibration of the timer overhead
+    const int iNCalibration = 1000;
+    double t_start = now();
+    for( int i = 0; i < iNCalibration; i++ )
+    {
+        now();
+    }
+    fTimerOverhead = ( now() - t_start ) / ( iNCalibration + 1 );
+
+    fStartTime = now();
+    for( int i = 0; i < N_STAGES; i++ )
+    {
+        fStageTime[i] = 0.;
+        fStageCalls[i] = 0;
+        fStageCounterCalls[i] = 0;
+        for( int c = 0; c < VPerfCounters::N_COUNTERS; c++ )
+        {
+            fStageCounters[i][c] = 0.;
+        }
+    }
+    fPhotonSampling = ( iPhotonSampling > 0 ? iPhotonSampling : 1 );
+    fPhotonCounter = 0;
+    fBytes = 0;
+    fBunches = 0;
+    fPhotonsGenerated = 0.;
+    fPhotonsSurviving = 0.;
+    fTelescopesRead = 0;
+    fTelescopesSkipped = 0;
+    fTrace = 0;
+    fPerf = 0;
+}
+
+/*!
+    string as JSON string value (without the enclosing quotes):
+    quotes, backslashes and control characters are escaped
+*/
+string VRunStatistics::escapeJSON( const string& iString )
+{
+    string iEscaped;
+    iEscaped.reserve( iString.size() );
+    for( unsigned int i = 0; i < iString.size(); i++ )
+    {
+        unsigned char c = ( unsigned char )iString[i];
+        switch( c )
+        {
+            case '"':
+                iEscaped += "\\\"";
+                break;
+            case '\\':
+                iEscaped += "\\\\";
+                break;
+            case '\b':
+                iEscaped += "\\b";
+                break;
+            case '\f':
+                iEscaped += "\\f";
+                break;
+            case '\n':
+                iEscaped += "\\n";
+                break;
+            case '\r':
+                iEscaped += "\\r";
+                break;
+            case '\t':
+                iEscaped += "\\t";
+                break;
+            default:
+                if( c < 0x20 )
+                {
+                    char hc[8];
+                    snprintf( hc, sizeof( hc ), "\\u%04x", c );
+                    iEscaped += hc;
+                }
+                else
+                {
+                    iEscaped += iString[i];
+                }
+        }
+    }
+    return iEscaped;
+}
+
+const char* VRunStatistics::getStageName( int iStage )
+{
+    static const char* iName[] = { "block_find", "block_read", "photon_decode", "photon_loop", "extinction",
+                                   "qe_lens", "histogram_fill", "grisu_write", "root_write"
+                                 };
+    if( iStage < 0 || iStage >= N_STAGES )
+    {
+        return "unknown";
+    }
+    return iName[iStage];
+}
+
+string VRunStatistics::getBlockName( int iType )
+{
+    switch( iType )
+    {
+        case IO_TYPE_MC_RUNH:
+            return "RUNH";
+        case IO_TYPE_MC_TELPOS:
+            return "TELPOS";
+        case IO_TYPE_MC_EVTH:
+            return "EVTH";
+        case IO_TYPE_MC_TELOFF:
+            return "TELOFF";
+        case IO_TYPE_MC_TELARRAY:
+            return "TELARRAY";
+        case IO_TYPE_MC_LONGI:
+            return "LONGI";
+        case IO_TYPE_MC_EVTE:
+            return "EVTE";
+        case IO_TYPE_MC_RUNE:
+            return "RUNE";
+        case IO_TYPE_MC_INPUTCFG:
+            return "INPUTCFG";
+        default:
+            return "other";
+    }
+}
+
+/*!
+    block of type iType with iBytes bytes (including block header)
+*/
+void VRunStatistics::countBlock( int iType, long long iBytes )
+{
+    fBlocks[iType]++;
+    fBlockBytes[iType] += iBytes;
+    fBytes += iBytes;
+}
+
+bool VRunStatistics::writeJSON( string iFile, string iInputFile )
+{
+    ofstream os( iFile.c_str() );
+    if( !os )
+    {
+        cout << "VRunStatistics: error opening statistics file " << iFile << endl;
+        return false;
+    }
+    double iWall = now() - fStartTime;
+    struct rusage ru;
+    getrusage( RUSAGE_SELF, &ru );
+    double iCPU = ru.ru_utime.tv_sec + 1.e-6 * ru.ru_utime.tv_usec + ru.ru_stime.tv_sec + 1.e-6 * ru.ru_stime.tv_usec;
+
+    double iStages = 0.;
+    for( int i = 0; i < N_STAGES; i++ )
+    {
+        if( i != PHOTON_LOOP )
+        {
+            iStages += fStageTime[i];
+        }
+    }
+    long long iEvents = ( fBlocks.count( IO_TYPE_MC_EVTE ) ? fBlocks[IO_TYPE_MC_EVTE] : 0 );
+    long long iArrays = ( fBlocks.count( IO_TYPE_MC_TELARRAY ) ? fBlocks[IO_TYPE_MC_TELARRAY] : 0 );
+
+    os.precision( 6 );
+    os << "{" << endl;
+    os << "  \"input\": \"" << escapeJSON( iInputFile ) << "\"," << endl;
+    os << "  \"wall_s\": " << iWall << "," << endl;
+    os << "  \"cpu_s\": " << iCPU << "," << endl;
+    os << "  \"photon_sampling\": " << fPhotonSampling << "," << endl;
+    os << "  \"timer_overhead_ns\": " << fTimerOverhead * 1.e9 << "," << endl;
+    if( fPerfStatus.size() > 0 )
+    {
+        os << "  \"perf_counters\": \"" << escapeJSON( fPerfStatus ) << "\"," << endl;
+    }
+    os << "  \"stages\": [" << endl;
+    for( int i = 0; i < N_STAGES; i++ )
+    {
+        os << "    { \"name\": \"" << escapeJSON( getStageName( i ) ) << "\", \"seconds\": " << fStageTime[i];
+        os << ", \"calls\": " << fStageCalls[i];
+        os << ", \"fraction\": " << ( iWall > 0. ? fStageTime[i] / iWall : 0. );
+        if( i == EXTINCTION || i == QE_LENS )
+        {
+            os << ", \"sampled\": true";
+        }
+        if( i == PHOTON_LOOP )
+        {
+            os << ", \"contains_other_stages\": true";
+        }
+        if( fPerf && fStageCounterCalls[i] > 0 )
+        {
+            if( fStageCounterCalls[i] < fStageCalls[i] )
+            {
+                os << ", \"counter_calls\": " << fStageCounterCalls[i];
+            }
+            for( int c = 0; c < VPerfCounters::N_COUNTERS; c++ )
+            {
+                if( fPerf->isAvailable( c ) )
+                {
+                    os << ", \"" << escapeJSON( VPerfCounters::getCounterName( c ) ) << "\": " << fStageCounters[i][c];
+                }
+            }
+            if( fPerf->isAvailable( VPerfCounters::CYCLES ) && fPerf->isAvailable( VPerfCounters::INSTRUCTIONS )
+                    && fStageCounters[i][VPerfCounters::CYCLES] > 0. )
+            {
+                os << ", \"ipc\": " << fStageCounters[i][VPerfCounters::INSTRUCTIONS] / fStageCounters[i][VPerfCounters::CYCLES];
+            }
+        }
+        os << " }," << endl;
+    }
+    os << "    { \"name\": \"other\", \"seconds\": " << iWall - iStages;
+    os << ", \"fraction\": " << ( iWall > 0. ? ( iWall - iStages ) / iWall : 0. ) << " }" << endl;
+    os << "  ]," << endl;
+    os << "  \"counters\": {" << endl;
+    os << "    \"events\": " << iEvents << "," << endl;
+    os << "    \"arrays\": " << iArrays << "," << endl;
+    os << "    \"bytes\": " << fBytes << "," << endl;
+    os << "    \"bunches\": " << fBunches << "," << endl;
+    os.setf( ios::fixed );
+    os.precision( 1 );
+    os << "    \"photons_generated\": " << fPhotonsGenerated << "," << endl;
+    os << "    \"photons_surviving\": " << fPhotonsSurviving << "," << endl;
+    os.unsetf( ios::fixed );
+    os.precision( 6 );
+    os << "    \"telescopes_read\": " << fTelescopesRead << "," << endl;
+    os << "    \"telescopes_skipped\": " << fTelescopesSkipped << endl;
+    os << "  }," << endl;
+    os << "  \"blocks\": [" << endl;
+    for( map< int, long long >::iterator it = fBlocks.begin(); it != fBlocks.end(); ++it )
+    {
+        if( it != fBlocks.begin() )
+        {
+            os << "," << endl;
+        }
+        os << "    { \"type\": " << it->first << ", \"name\": \"" << escapeJSON( getBlockName( it->first ) ) << "\"";
+        os << ", \"count\": " << it->second << ", \"bytes\": " << fBlockBytes[it->first] << " }";
+    }
+    os << endl << "  ]" << endl;
+    os << "}" << endl;
+    os.close();
+    return true;
+}
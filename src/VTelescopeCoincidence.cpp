@@ -0,0 +1,213 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VTelescopeCoincidence
+    \brief photon arrival time coincidences between telescopes
+
+    Photon arrival times of one event are radix sorted (together with
+    the telescope number) in a single pass and split into time ordered
+    streams per telescope.
+
+    Results per event:
+
+    - number of photon pairs with |t_A - t_B| <= window for each
+      telescope pair A < B (only pairs with coincidences are listed)
+    - multiplicity: maximum number of telescopes with photons inside
+      one coincidence window
+*/
+
+#include "VTelescopeCoincidence.h"
+
+VTelescopeCoincidence::VTelescopeCoincidence( double iWindow )
+{
+    fWindow = iWindow;
+    fMultiplicity = 0;
+}
+
+void VTelescopeCoincidence::clear()
+{
+    fKeys.clear();
+    fTelA.clear();
+    fTelB.clear();
+    fNPairs.clear();
+    fMultiplicity = 0;
+}
+
+/*!
+    map float to unsigned int with the same ordering
+*/
+unsigned int VTelescopeCoincidence::timeKey( float t )
+{
+    unsigned int k = 0;
+    memcpy( &k, &t, sizeof( k ) );
+    return ( k & 0x80000000u ) ? ~k : ( k | 0x80000000u );
+}
+
+float VTelescopeCoincidence::keyTime( unsigned int k )
+{
+    k = ( k & 0x80000000u ) ? ( k & 0x7fffffffu ) : ~k;
+    float t = 0.;
+    memcpy( &t, &k, sizeof( t ) );
+    return t;
+}
+
+/*!
+    photon with arrival time t [ns] in telescope iTel (counting from 0)
+*/
+void VTelescopeCoincidence::fill( int iTel, float t )
+{
+    if( iTel < 0 || iTel > 0xffff )
+    {
+        return;
+    }
+    fKeys.push_back( ( ( unsigned long long )timeKey( t ) << 16 ) | ( unsigned long long )iTel );
+}
+
+/*!
+    LSD radix sort of the time keys (bits 16 to 47 of fKeys; stable)
+*/
+void VTelescopeCoincidence::radixSort()
+{
+    fScratch.resize( fKeys.size() );
+    unsigned int iCount[256];
+    for( unsigned int iShift = 16; iShift < 48; iShift += 8 )
+    {
+        memset( iCount, 0, sizeof( iCount ) );
+        for( unsigned int i = 0; i < fKeys.size(); i++ )
+        {
+            iCount[( fKeys[i] >> iShift ) & 0xff]++;
+        }
+        // all keys in one bucket: nothing to do for this digit
+        if( iCount[( fKeys[0] >> iShift ) & 0xff] == fKeys.size() )
+        {
+            continue;
+        }
+        unsigned int iSum = 0;
+        for( unsigned int b = 0; b < 256; b++ )
+        {
+            unsigned int c = iCount[b];
+            iCount[b] = iSum;
+            iSum += c;
+        }
+        for( unsigned int i = 0; i < fKeys.size(); i++ )
+        {
+            fScratch[iCount[( fKeys[i] >> iShift ) & 0xff]++] = fKeys[i];
+        }
+        fKeys.swap( fScratch );
+    }
+}
+
+void VTelescopeCoincidence::evaluate()
+{
+    fTelA.clear();
+    fTelB.clear();
+    fNPairs.clear();
+    fMultiplicity = 0;
+    if( fKeys.size() == 0 )
+    {
+        return;
+    }
+    radixSort();
+
+    // time ordered streams per telescope
+    for( unsigned int t = 0; t < fStream.size(); t++ )
+    {
+        fStream[t].clear();
+    }
+    for( unsigned int i = 0; i < fKeys.size(); i++ )
+    {
+        unsigned int iTel = ( unsigned int )( fKeys[i] & 0xffff );
+        if( iTel >= fStream.size() )
+        {
+            fStream.resize( iTel + 1 );
+            fTelCounts.resize( iTel + 1, 0 );
+        }
+        fStream[iTel].push_back( keyTime( ( unsigned int )( fKeys[i] >> 16 ) ) );
+    }
+
+    // photon pairs within the coincidence window for all telescope pairs
+    for( unsigned int a = 0; a < fStream.size(); a++ )
+    {
+        const vector< float >& tA = fStream[a];
+        if( tA.size() == 0 )
+        {
+            continue;
+        }
+        for( unsigned int b = a + 1; b < fStream.size(); b++ )
+        {
+            const vector< float >& tB = fStream[b];
+            if( tB.size() == 0 )
+            {
+                continue;
+            }
+            double nPairs = 0.;
+            unsigned int iLow = 0;
+            unsigned int iHigh = 0;
+            for( unsigned int i = 0; i < tA.size(); i++ )
+            {
+                while( iLow < tB.size() && tB[iLow] < tA[i] - fWindow )
+                {
+                    iLow++;
+                }
+                if( iHigh < iLow )
+                {
+                    iHigh = iLow;
+                }
+                while( iHigh < tB.size() && tB[iHigh] <= tA[i] + fWindow )
+                {
+                    iHigh++;
+                }
+                nPairs += ( double )( iHigh - iLow );
+            }
+            if( nPairs > 0. )
+            {
+                fTelA.push_back( ( int )a );
+                fTelB.push_back( ( int )b );
+                fNPairs.push_back( nPairs );
+            }
+        }
+    }
+
+    // maximum number of telescopes inside a sliding coincidence window
+    int nTel = 0;
+    unsigned int iStart = 0;
+    for( unsigned int i = 0; i < fKeys.size(); i++ )
+    {
+        if( fTelCounts[fKeys[i] & 0xffff]++ == 0 )
+        {
+            nTel++;
+        }
+        float t = keyTime( ( unsigned int )( fKeys[i] >> 16 ) );
+        while( t - keyTime( ( unsigned int )( fKeys[iStart] >> 16 ) ) > fWindow )
+        {
+            if( --fTelCounts[fKeys[iStart] & 0xffff] == 0 )
+            {
+                nTel--;
+            }
+            iStart++;
+        }
+        if( nTel > fMultiplicity )
+        {
+            fMultiplicity = nTel;
+        }
+    }
+    for( unsigned int t = 0; t < fTelCounts.size(); t++ )
+    {
+        fTelCounts[t] = 0;
+    }
+}
@@ -0,0 +1,159 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================*/
+/*! \class VTraceWriter
+    \brief timeline of the processing pipeline in Chrome trace-event format (-trace)
+
+    Spans are written as they are closed into a JSON file in the Chrome
+    trace-event format (viewable in Perfetto, https://ui.perfetto.dev,
+    or chrome://tracing). Nested spans are opened and closed with
+    begin()/end(); spans with known start and duration are written
+    with complete(). Times are in microseconds since open().
+
+    Names and categories are escaped; arguments of spans (iArgs) are
+    JSON objects, e.g. "{\"tel\": 3}", and are written as given.
+*/
+
+#include "VTraceWriter.h"
+#include "VRunStatistics.h"
+
+VTraceWriter::VTraceWriter()
+{
+    fFile = 0;
+    fStartTime = 0.;
+    fNTraceEvents = 0;
+}
+
+VTraceWriter::~VTraceWriter()
+{
+    close();
+}
+
+bool VTraceWriter::open( string iFile, string iProcessName )
+{
+    close();
+    fFileName = iFile;
+    fFile = fopen( fFileName.c_str(), "w" );
+    if( !fFile )
+    {
+        perror( fFileName.c_str() );
+        return false;
+    }
+    fStartTime = VRunStatistics::now();
+    fNTraceEvents = 0;
+    fprintf( fFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    fprintf( fFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"%s\"}}",
+             VRunStatistics::escapeJSON( iProcessName ).c_str() );
+    return true;
+}
+
+/*!
+    close all open spans and the trace file
+*/
+void VTraceWriter::close()
+{
+    if( !fFile )
+    {
+        return;
+    }
+    while( fOpenSpans.size() > 0 )
+    {
+        end();
+    }
+    fprintf( fFile, "\n]}\n" );
+    fclose( fFile );
+    fFile = 0;
+}
+
+void VTraceWriter::writeEvent( const string& iName, const string& iCategory, char iPhase, double iTime, double iDuration, const string& iArgs )
+{
+    fprintf( fFile, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f", VRunStatistics::escapeJSON( iName ).c_str(),
+             VRunStatistics::escapeJSON( iCategory ).c_str(), iPhase, ( iTime - fStartTime ) * 1.e6 );
+    if( iPhase == 'X' )
+    {
+        fprintf( fFile, ",\"dur\":%.3f", iDuration * 1.e6 );
+    }
+    fprintf( fFile, ",\"pid\":1,\"tid\":1" );
+    if( iArgs.size() > 0 )
+    {
+        fprintf( fFile, ",\"args\":%s", iArgs.c_str() );
+    }
+    fprintf( fFile, "}" );
+    fNTraceEvents++;
+}
+
+/*!
+    open a span (closed with end())
+*/
+void VTraceWriter::begin( string iName, string iCategory, string iArgs )
+{
+    if( !fFile )
+    {
+        return;
+    }
+    writeEvent( iName, iCategory, 'B', VRunStatistics::now(), 0., iArgs );
+    fOpenSpans.push_back( iName );
+}
+
+/*!
+    close the last span opened with begin()
+*/
+void VTraceWriter::end( string iArgs )
+{
+    if( !fFile || fOpenSpans.size() == 0 )
+    {
+        return;
+    }
+    writeEvent( fOpenSpans.back(), "", 'E', VRunStatistics::now(), 0., iArgs );
+    fOpenSpans.pop_back();
+}
+
+/*!
+    span with start time iStart (VRunStatistics::now()) and duration iDuration [s]
+*/
+void VTraceWriter::complete( string iName, string iCategory, double iStart, double iDuration, string iArgs )
+{
+    if( !fFile )
+    {
+        return;
+    }
+    writeEvent( iName, iCategory, 'X', iStart, iDuration, iArgs );
+}
+
+VTraceSpan::VTraceSpan( VTraceWriter* iTrace, string iName, string iCategory )
+{
+    fTrace = ( iTrace && iTrace->isOpen() ? iTrace : 0 );
+    if( fTrace )
+    {
+        fName = iName;
+        fCategory = iCategory;
+        fStart = VRunStatistics::now();
+    }
+    else
+    {
+        fStart = 0.;
+    }
+}
+
+VTraceSpan::~VTraceSpan()
+{
+    if( fTrace )
+    {
+        fTrace->complete( fName, fCategory, fStart, VRunStatistics::now() - fStart, fArgs );
+    }
+}
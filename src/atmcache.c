@@ -0,0 +1,286 @@
+/* ============================================================================
+
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+============================================================================ */
+
+/** @file atmcache.c
+ *  @short Binary cache for parsed atmospheric tables.
+ *
+ *  Parsing the text tables of atmospheric profiles and extinction
+ *  coefficients (and deriving the interpolation tables from them)
+ *  is repeated by every job. The result of the parsing is therefore
+ *  stored in a binary cache file which is memory mapped by later jobs.
+ *
+ *  A cache file is identified by the source file and a tag describing
+ *  the content (e.g. the atmospheric model and observation level).
+ *  It is only used if path, size and modification time of the source
+ *  file recorded in its header match the current source file. Any
+ *  problem with the cache (missing, outdated, unwritable directory)
+ *  falls back to parsing the text tables. Problems other than a
+ *  missing or outdated cache file are reported once per job.
+ *
+ *  The source file name must be the name of the file actually read
+ *  (e.g. resolved with findpath(), see fileopen.c).
+ *
+ *  Cache files are written next to the source file, or into the
+ *  directory given by the environment variable CORSIKAIO_CACHE_DIR.
+ *  Setting CORSIKAIO_NO_CACHE disables the cache.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "../inc/atmcache.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define ATMCACHE_MAGIC "CIOATMC"
+
+/** Header at the start of each cache file (payload follows). */
+struct atmcache_header
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t header_size;
+   int64_t src_size;
+   int64_t src_mtime;
+   uint64_t data_size;
+   char tag[64];
+   char src_path[1024];
+};
+
+/* ------------------------ atmcache_report ----------------------- */
+/**
+ *  @short Report (once) that the cache can not be used.
+*/
+
+static void atmcache_report(const char *reason, const char *fname)
+{
+   static int reported = 0;
+
+   if ( reported )
+      return;
+   reported = 1;
+   fprintf(stderr,"Binary cache of atmospheric tables not used: %s (%s).\n",
+      reason, (fname != NULL) ? fname : "-");
+}
+
+/* ------------------------ atmcache_source ----------------------- */
+/**
+ *  @short Fill the header fields identifying source file and content.
+ *
+ *  @return 0 (o.k.), -1 (source not found or cache disabled)
+*/
+
+static int atmcache_source(const char *src_fname, const char *tag,
+   struct atmcache_header *h)
+{
+   struct stat st;
+   char rpath[PATH_MAX];
+
+   if ( getenv("CORSIKAIO_NO_CACHE") != NULL )
+      return -1;
+   if ( src_fname == NULL || tag == NULL || strlen(tag) >= sizeof(h->tag) )
+      return -1;
+   if ( stat(src_fname,&st) != 0 || !S_ISREG(st.st_mode) )
+   {
+      atmcache_report("source file not found",src_fname);
+      return -1;
+   }
+   if ( realpath(src_fname,rpath) == NULL ||
+        strlen(rpath) >= sizeof(h->src_path) )
+   {
+      atmcache_report("source path not resolved",src_fname);
+      return -1;
+   }
+
+   memset(h,0,sizeof(*h));
+   memcpy(h->magic,ATMCACHE_MAGIC,sizeof(ATMCACHE_MAGIC));
+   h->version = ATMCACHE_VERSION;
+   h->header_size = (uint32_t) sizeof(*h);
+   h->src_size = (int64_t) st.st_size;
+   h->src_mtime = (int64_t) st.st_mtime;
+   strcpy(h->tag,tag);
+   strcpy(h->src_path,rpath);
+   return 0;
+}
+
+/* ------------------------- atmcache_name ------------------------ */
+/**
+ *  @short Name of the cache file for a given source file and tag.
+ *
+ *  In a common cache directory the name includes a hash of the
+ *  full source path to keep files from different directories apart.
+*/
+
+static int atmcache_name(const struct atmcache_header *h,
+   char *fname, size_t len)
+{
+   const char *dir = getenv("CORSIKAIO_CACHE_DIR");
+   const char *base = strrchr(h->src_path,'/');
+   uint32_t hash = 2166136261u;
+   const char *s;
+   int n;
+
+   base = (base != NULL) ? base+1 : h->src_path;
+   if ( dir != NULL && *dir != '\0' )
+   {
+      for ( s=h->src_path; *s; s++ )
+         hash = (hash ^ (unsigned char) *s) * 16777619u;
+      n = snprintf(fname,len,"%s/%s.%s.%08x.cache",dir,base,h->tag,
+         (unsigned) hash);
+   }
+   else
+      n = snprintf(fname,len,"%s.%s.cache",h->src_path,h->tag);
+
+   if ( n < 0 || (size_t) n >= len )
+   {
+      atmcache_report("cache file name too long",h->src_path);
+      return -1;
+   }
+   return 0;
+}
+
+/* ------------------------- atmcache_open ------------------------ */
+/**
+ *  @short Map an up-to-date cache file for the given source and tag.
+ *
+ *  @param src_fname  Name of the text table the cache was derived from.
+ *  @param tag        Description of the cached content.
+ *  @param m          Filled with the mapping on success.
+ *
+ *  @return 0 (cache mapped), -1 (no valid cache; parse the source)
+*/
+
+int atmcache_open(const char *src_fname, const char *tag,
+   struct atmcache_map *m)
+{
+   struct atmcache_header h;
+   const struct atmcache_header *hc;
+   char fname[PATH_MAX+256];
+   struct stat st;
+   void *addr;
+   int fd;
+
+   if ( m == NULL )
+      return -1;
+   memset(m,0,sizeof(*m));
+   if ( atmcache_source(src_fname,tag,&h) != 0 ||
+        atmcache_name(&h,fname,sizeof(fname)) != 0 )
+      return -1;
+
+   if ( (fd = open(fname,O_RDONLY)) < 0 )
+      return -1;
+   if ( fstat(fd,&st) != 0 || (size_t) st.st_size < sizeof(h) )
+   {
+      close(fd);
+      return -1;
+   }
+   addr = mmap(NULL,(size_t) st.st_size,PROT_READ,MAP_SHARED,fd,0);
+   close(fd);
+   if ( addr == MAP_FAILED )
+      return -1;
+
+   hc = (const struct atmcache_header *) addr;
+   if ( memcmp(hc->magic,h.magic,sizeof(h.magic)) != 0 ||
+        hc->version != h.version ||
+        hc->header_size != h.header_size ||
+        hc->src_size != h.src_size ||
+        hc->src_mtime != h.src_mtime ||
+        hc->data_size != (uint64_t) st.st_size - sizeof(h) ||
+        strncmp(hc->tag,h.tag,sizeof(h.tag)) != 0 ||
+        strncmp(hc->src_path,h.src_path,sizeof(h.src_path)) != 0 )
+   {
+      munmap(addr,(size_t) st.st_size);
+      return -1;
+   }
+
+   m->addr = addr;
+   m->len = (size_t) st.st_size;
+   m->data = (const char *) addr + sizeof(h);
+   m->data_len = (size_t) hc->data_size;
+   return 0;
+}
+
+/* ------------------------ atmcache_close ------------------------ */
+/**
+ *  @short Release a mapping obtained with atmcache_open().
+*/
+
+void atmcache_close(struct atmcache_map *m)
+{
+   if ( m == NULL || m->addr == NULL )
+      return;
+   munmap(m->addr,m->len);
+   memset(m,0,sizeof(*m));
+}
+
+/* ------------------------ atmcache_write ------------------------ */
+/**
+ *  @short Write a cache file for the given source and tag.
+ *
+ *  The file is written under a temporary name and renamed at the
+ *  end such that concurrent jobs never see incomplete cache files.
+ *
+ *  @return 0 (o.k.), -1 (cache not written)
+*/
+
+int atmcache_write(const char *src_fname, const char *tag,
+   const void *data, size_t len)
+{
+   struct atmcache_header h;
+   char fname[PATH_MAX+256], tmp_fname[PATH_MAX+300];
+   FILE *f;
+   int ok;
+
+   if ( data == NULL && len > 0 )
+      return -1;
+   if ( atmcache_source(src_fname,tag,&h) != 0 ||
+        atmcache_name(&h,fname,sizeof(fname)) != 0 )
+      return -1;
+   h.data_size = (uint64_t) len;
+
+   snprintf(tmp_fname,sizeof(tmp_fname),"%s.tmp%ld",fname,(long) getpid());
+   if ( (f = fopen(tmp_fname,"wb")) == NULL )
+   {
+      atmcache_report("cache directory not writable",tmp_fname);
+      return -1;
+   }
+   ok = ( fwrite(&h,sizeof(h),1,f) == 1 );
+   if ( ok && len > 0 )
+      ok = ( fwrite(data,len,1,f) == 1 );
+   if ( fclose(f) != 0 )
+      ok = 0;
+   if ( !ok || rename(tmp_fname,fname) != 0 )
+   {
+      atmcache_report("cache file not written",fname);
+      unlink(tmp_fname);
+      return -1;
+   }
+   return 0;
+}
@@ -57,9 +57,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "../inc/atmo.h"
+#include "../inc/atmcache.h"
 #include "../inc/fileopen.h"
 
 /*
@@ -108,6 +110,14 @@ static double fast_p_log_rho[MAX_FAST_PROFILE];
 static double fast_p_log_thick[MAX_FAST_PROFILE];
 static double fast_p_log_n1[MAX_FAST_PROFILE];
 static double fast_h_fac;
+/* Refraction bending coefficients on the same equidistant altitude grid */
+static double fast_p_bend_ray_hori_a[MAX_FAST_PROFILE];
+static double fast_p_bend_ray_time0[MAX_FAST_PROFILE];
+static double fast_p_bend_ray_time_a[MAX_FAST_PROFILE];
+/* Inverse table: altitude on an equidistant grid in log(thickness) */
+static double fast_t_alt[MAX_FAST_PROFILE];
+static double fast_t_log_thick_max, fast_t_log_thick_min;
+static double fast_t_fac;
 #endif
 
 /* ================================================================== */
@@ -334,6 +344,22 @@ static void init_refraction_tables()
       else
          p_bend_ray_time_a[ialt] = 0.;
    }
+
+#ifdef FAST_INTERPOLATION
+   /* Same coefficients on the equidistant grid used by raybnd_(). */
+   /* The two coefficients interpolated in density are tabulated */
+   /* as a function of altitude via the density profile. */
+   for (ialt=0; ialt<MAX_FAST_PROFILE; ialt++)
+   {
+      double rho = rhofx_(&fast_p_alt[ialt]);
+      fast_p_bend_ray_time0[ialt] = 
+         rpol(p_alt,p_bend_ray_time0,num_prof,fast_p_alt[ialt]);
+      fast_p_bend_ray_hori_a[ialt] =
+         rpol(p_rho,p_bend_ray_hori_a,num_prof,rho);
+      fast_p_bend_ray_time_a[ialt] =
+         rpol(p_rho,p_bend_ray_time_a,num_prof,rho);
+   }
+#endif
 }
 
 /* ------------------- init_fast_interpolation ---------------------- */
@@ -362,6 +388,50 @@ static void init_fast_interpolation()
    
    fast_h_fac = (double)(MAX_FAST_PROFILE-1) / 
         (top_of_atmosphere - bottom_of_atmosphere);
+
+   /* The inverse (altitude as a function of thickness) is tabulated */
+   /* equidistant in log(thickness), skipping any levels at the top */
+   /* with vanishing thickness (these are handled by rpol()). */
+   fast_t_log_thick_max = p_log_thick[0];
+   fast_t_log_thick_min = p_log_thick[0];
+   for ( i=1; i<num_prof; i++ )
+      if ( p_log_thick[i] > -99. )
+         fast_t_log_thick_min = p_log_thick[i];
+   if ( fast_t_log_thick_max > fast_t_log_thick_min )
+      fast_t_fac = (double)(MAX_FAST_PROFILE-1) /
+         (fast_t_log_thick_max - fast_t_log_thick_min);
+   else
+      fast_t_fac = 0.;
+   for ( i=0; i<MAX_FAST_PROFILE; i++)
+   {
+      double lt;
+      if ( i<MAX_FAST_PROFILE-1 && fast_t_fac > 0. )
+         lt = fast_t_log_thick_max - (double) i / fast_t_fac;
+      else
+         lt = fast_t_log_thick_min;
+      fast_t_alt[i] = rpol(p_log_thick,p_alt,num_prof,lt);
+   }
+}
+
+/* ----------------------- fast_alt_rpol -------------------------- */
+/**
+ *  @short Linear interpolation in one of the equidistant altitude tables.
+ *
+ *  Values outside the tabulated range are those at the corresponding
+ *  edge, as with rpol().
+ */
+
+static double fast_alt_rpol (double *ftab, double height)
+{
+   int i;
+   double r;
+   if ( height <= bottom_of_atmosphere )
+      return ftab[0];
+   i = (int) ( fast_h_fac * (height-bottom_of_atmosphere) );
+   if ( i >= MAX_FAST_PROFILE-1 )
+      return ftab[MAX_FAST_PROFILE-1];
+   r = fast_h_fac * (height-fast_p_alt[i]);
+   return (1.-r)*ftab[i] + r*ftab[i+1];
 }
 #endif
 
@@ -383,6 +453,123 @@ static void init_fast_interpolation()
 */
 
 
+/* ==================================================================== */
+/*
+   Binary cache of the tables derived from an atmospheric profile file.
+   The refraction tables depend on the observation level, which is
+   therefore part of the cache tag.
+*/
+
+struct atm_cache_item
+{
+   void *ptr;
+   size_t size;
+};
+
+static const struct atm_cache_item atm_cache_items[] =
+{
+   { &num_prof, sizeof(num_prof) },
+   { p_alt, sizeof(p_alt) },
+   { p_log_alt, sizeof(p_log_alt) },
+   { p_log_rho, sizeof(p_log_rho) },
+   { p_rho, sizeof(p_rho) },
+   { p_log_thick, sizeof(p_log_thick) },
+   { p_log_n1, sizeof(p_log_n1) },
+   { p_bend_ray_hori_a, sizeof(p_bend_ray_hori_a) },
+   { p_bend_ray_time0, sizeof(p_bend_ray_time0) },
+   { p_bend_ray_time_a, sizeof(p_bend_ray_time_a) },
+   { &top_of_atmosphere, sizeof(top_of_atmosphere) },
+   { &bottom_of_atmosphere, sizeof(bottom_of_atmosphere) },
+   { &etadsn, sizeof(etadsn) },
+#ifdef FAST_INTERPOLATION
+   { fast_p_alt, sizeof(fast_p_alt) },
+   { fast_p_log_rho, sizeof(fast_p_log_rho) },
+   { fast_p_log_thick, sizeof(fast_p_log_thick) },
+   { fast_p_log_n1, sizeof(fast_p_log_n1) },
+   { &fast_h_fac, sizeof(fast_h_fac) },
+   { fast_p_bend_ray_hori_a, sizeof(fast_p_bend_ray_hori_a) },
+   { fast_p_bend_ray_time0, sizeof(fast_p_bend_ray_time0) },
+   { fast_p_bend_ray_time_a, sizeof(fast_p_bend_ray_time_a) },
+   { fast_t_alt, sizeof(fast_t_alt) },
+   { &fast_t_log_thick_max, sizeof(fast_t_log_thick_max) },
+   { &fast_t_log_thick_min, sizeof(fast_t_log_thick_min) },
+   { &fast_t_fac, sizeof(fast_t_fac) },
+#endif
+   { NULL, 0 }
+};
+
+static void atm_cache_tag(char *tag, size_t len)
+{
+#ifdef FAST_INTERPOLATION
+   snprintf(tag,len,"atmo_fast_obs%.0f",observation_level);
+#else
+   snprintf(tag,len,"atmo_obs%.0f",observation_level);
+#endif
+}
+
+/* ---------------------- load_atmosphere_cache ---------------------- */
+/**
+ *  @short Restore all tables of an atmospheric profile from the cache.
+ *
+ *  @return 0 (o.k.), -1 (no valid cache)
+*/
+
+static int load_atmosphere_cache(const char *fname)
+{
+   struct atmcache_map m;
+   const struct atm_cache_item *item;
+   const char *data;
+   size_t len = 0;
+   char tag[64];
+
+   for ( item=atm_cache_items; item->ptr != NULL; item++ )
+      len += item->size;
+
+   atm_cache_tag(tag,sizeof(tag));
+   if ( atmcache_open(fname,tag,&m) != 0 )
+      return -1;
+   if ( m.data_len != len )
+   {
+      atmcache_close(&m);
+      return -1;
+   }
+   data = (const char *) m.data;
+   for ( item=atm_cache_items; item->ptr != NULL; item++ )
+   {
+      memcpy(item->ptr,data,item->size);
+      data += item->size;
+   }
+   atmcache_close(&m);
+   return 0;
+}
+
+/* ---------------------- save_atmosphere_cache ---------------------- */
+/**
+ *  @short Write all tables of an atmospheric profile to the cache.
+ *  Failures are ignored (the tables are then just parsed again).
+*/
+
+static void save_atmosphere_cache(const char *fname)
+{
+   const struct atm_cache_item *item;
+   char *data, *d;
+   size_t len = 0;
+   char tag[64];
+
+   for ( item=atm_cache_items; item->ptr != NULL; item++ )
+      len += item->size;
+   if ( (data = (char *) malloc(len)) == NULL )
+      return;
+   for ( d=data, item=atm_cache_items; item->ptr != NULL; item++ )
+   {
+      memcpy(d,item->ptr,item->size);
+      d += item->size;
+   }
+   atm_cache_tag(tag,sizeof(tag));
+   atmcache_write(fname,tag,data,len);
+   free(data);
+}
+
 /* ----------------------- init_atmosphere ------------------------ */
 /**
  *  @short Initialize atmospheric profiles.
@@ -397,11 +584,15 @@ static void init_fast_interpolation()
  *  index of refraction, ...) all parameters are transformed such
  *  that linear interpolation can be easily used.
  *
+ *  The derived tables are taken from the binary cache (see atmcache.c)
+ *  if an up-to-date cache file exists for the profile file.
+ *
 */
 
 static void init_atmosphere ()
 {
    char fname[128];
+   char fpath[1024];
    FILE *f;
    char line[1024];
    int count;
@@ -423,6 +614,10 @@ static void init_atmosphere ()
 #else
    sprintf(fname,"atm_profile_model_%d.dat",atmosphere);
 #endif
+   /* The cache is keyed by the file fileopen() reads (search path resolved). */
+   if ( findpath(fname,fpath,sizeof(fpath)) == 0 &&
+        load_atmosphere_cache(fpath) == 0 )
+      return;
    if ( (f=fileopen(fname,"r")) == NULL )
    {
       perror(fname);
@@ -437,6 +632,12 @@ static void init_atmosphere ()
          perror(fname);
          exit(1);
       }
+      if ( findpath(fname,fpath,sizeof(fpath)) == 0 &&
+           load_atmosphere_cache(fpath) == 0 )
+      {
+         fclose(f);
+         return;
+      }
    }
 
    count = num_prof = 0;
@@ -496,6 +697,11 @@ static void init_atmosphere ()
 
    /* Initialize the tables for the refraction bending */
    init_refraction_tables();
+
+   if ( findpath(fname,fpath,sizeof(fpath)) == 0 )
+      save_atmosphere_cache(fpath);
+   else
+      save_atmosphere_cache(fname);
 }
 
 /* -------------------------- atmset_ ---------------------------- */
@@ -634,16 +840,183 @@ double refidx_ (double *height)
 
 double heighx_ (double *thick)
 {
-   double h;
+   double h, lt;
    if ( (*thick) <= 0. )
       return top_of_atmosphere;
-   h = rpol(p_log_thick,p_alt,num_prof,log(*thick));
+   lt = log(*thick);
+#ifdef FAST_INTERPOLATION
+   if ( lt <= fast_t_log_thick_max && lt >= fast_t_log_thick_min && 
+        fast_t_fac > 0. )
+   {
+      int i;
+      double r = fast_t_fac * (fast_t_log_thick_max-lt);
+      i = (int) r;
+      if ( i < MAX_FAST_PROFILE-1 )
+      {
+         r -= (double) i;
+         h = (1.-r)*fast_t_alt[i] + r*fast_t_alt[i+1];
+         return ( h < top_of_atmosphere ) ? h : top_of_atmosphere;
+      }
+   }
+#endif
+   h = rpol(p_log_thick,p_alt,num_prof,lt);
    if ( h < top_of_atmosphere )
       return h;
    else
       return top_of_atmosphere;
 }
 
+/* ------------------------ batch interpolation --------------------- */
+/*
+   Vector versions of rhofx_(), thickx_(), refidx_() and heighx_() for
+   use from C/C++ loops over many photons or levels. With the fast
+   interpolation tables the table index and interpolation fraction are
+   evaluated in a first loop without function calls (which the compiler
+   can vectorize), and the exponential is applied in a second loop.
+*/
+
+#ifdef FAST_INTERPOLATION
+/**
+ *  @short Interpolate log values of one of the equidistant altitude tables.
+ *
+ *  @param  ftab   Input: table on the fast altitude grid
+ *  @param  height Input: altitudes [cm]
+ *  @param  val    Output: interpolated (log) values
+ *  @param  n      Input: number of altitudes
+ *  @param  vtop   Input: value returned at/above the top of the atmosphere
+ */
+
+static void fast_alt_log_batch (double *ftab, const double *height,
+   double *val, int n, double vtop)
+{
+   int k;
+   for ( k=0; k<n; k++ )
+   {
+      double x = fast_h_fac * (height[k]-bottom_of_atmosphere);
+      int i;
+      double r;
+      /* Top of atmosphere (also infinite and NaN heights) is tested */
+      /* before the conversion to int, which is undefined out of range. */
+      int top = !(height[k] < top_of_atmosphere) ||
+                !(x < (double)(MAX_FAST_PROFILE-1));
+      if ( top || x < 0. )
+         x = 0.;
+      i = (int) x;
+      if ( i > MAX_FAST_PROFILE-2 )
+         i = MAX_FAST_PROFILE-2;
+      r = x - (double) i;
+      val[k] = top ? vtop : (1.-r)*ftab[i] + r*ftab[i+1];
+   }
+}
+#endif
+
+/* ---------------------------- rhofx_batch ------------------------- */
+/**
+ *  @short Density [g/cm**3] for a vector of altitudes [cm].
+ *
+ *  @param  height  Input: altitudes [cm]
+ *  @param  rho     Output: densities [g/cm**3]
+ *  @param  n       Input: number of elements
+*/
+
+void rhofx_batch (const double *height, double *rho, int n)
+{
+#ifdef FAST_INTERPOLATION
+   int k;
+   fast_alt_log_batch(fast_p_log_rho,height,rho,n,-1000.);
+   for ( k=0; k<n; k++ )
+      rho[k] = ( height[k] < bottom_of_atmosphere ) ? p_rho[0] : exp(rho[k]);
+#else
+   int k;
+   for ( k=0; k<n; k++ )
+      rho[k] = rhofx_((double *)&height[k]);
+#endif
+}
+
+/* ---------------------------- thickx_batch ------------------------ */
+/**
+ *  @short Atmospheric thickness [g/cm**2] for a vector of altitudes [cm].
+ *
+ *  @param  height  Input: altitudes [cm]
+ *  @param  thick   Output: thicknesses [g/cm**2]
+ *  @param  n       Input: number of elements
+*/
+
+void thickx_batch (const double *height, double *thick, int n)
+{
+#ifdef FAST_INTERPOLATION
+   int k;
+   fast_alt_log_batch(fast_p_log_thick,height,thick,n,-1000.);
+   for ( k=0; k<n; k++ )
+      thick[k] = exp(thick[k]);
+#else
+   int k;
+   for ( k=0; k<n; k++ )
+      thick[k] = thickx_((double *)&height[k]);
+#endif
+}
+
+/* ---------------------------- refidx_batch ------------------------ */
+/**
+ *  @short Index of refraction for a vector of altitudes [cm].
+ *
+ *  @param  height  Input: altitudes [cm]
+ *  @param  n_ref   Output: indices of refraction
+ *  @param  n       Input: number of elements
+*/
+
+void refidx_batch (const double *height, double *n_ref, int n)
+{
+#ifdef FAST_INTERPOLATION
+   int k;
+   fast_alt_log_batch(fast_p_log_n1,height,n_ref,n,-1000.);
+   for ( k=0; k<n; k++ )
+      n_ref[k] = 1.+exp(n_ref[k]);
+#else
+   int k;
+   for ( k=0; k<n; k++ )
+      n_ref[k] = refidx_((double *)&height[k]);
+#endif
+}
+
+/* ---------------------------- heighx_batch ------------------------ */
+/**
+ *  @short Altitude [cm] for a vector of atmospheric thicknesses [g/cm**2].
+ *
+ *  @param  thick   Input: atmospheric thicknesses [g/cm**2]
+ *  @param  height  Output: altitudes [cm]
+ *  @param  n       Input: number of elements
+*/
+
+void heighx_batch (const double *thick, double *height, int n)
+{
+   int k;
+#ifdef FAST_INTERPOLATION
+   for ( k=0; k<n; k++ )
+      height[k] = ( thick[k] > 0. ) ? log(thick[k]) : 0.;
+   for ( k=0; k<n; k++ )
+   {
+      double lt = height[k];
+      double x = fast_t_fac * (fast_t_log_thick_max-lt);
+      int i;
+      if ( thick[k] <= 0. || lt > fast_t_log_thick_max || 
+           lt < fast_t_log_thick_min || x >= (double)(MAX_FAST_PROFILE-1) )
+      {
+         height[k] = heighx_((double *)&thick[k]);
+         continue;
+      }
+      i = (int) x;
+      x -= (double) i;
+      height[k] = (1.-x)*fast_t_alt[i] + x*fast_t_alt[i+1];
+      if ( height[k] > top_of_atmosphere )
+         height[k] = top_of_atmosphere;
+   }
+#else
+   for ( k=0; k<n; k++ )
+      height[k] = heighx_((double *)&thick[k]);
+#endif
+}
+
 /* ---------------------------- raybnd_ ---------------------------- */
 /**
  *  @short Calculate the bending of light due to atmospheric refraction.
@@ -674,7 +1047,10 @@ void raybnd_(double *zem, cors_real_now_t *u, cors_real_now_t *v,
    double *w, cors_real_now_t *dx, cors_real_now_t *dy, cors_real_now_t *dt)
 {
    double sin_t_em, sin_t_obs, theta_em, theta_obs;
-   double c, s, h, t, rho;
+   double c, s, h, t;
+#ifndef FAST_INTERPOLATION
+   double rho;
+#endif
    double hori_off, travel_time;
    double vc = 29.9792458; /* velocity of light [cm/ns] */
    
@@ -684,7 +1060,11 @@ void raybnd_(double *zem, cors_real_now_t *u, cors_real_now_t *v,
    {   /* Exactly vertical: no bending; just calulate travel time. */
       *dt += (((*zem) - observation_level) + 
          etadsn*(obs_level_thick-thickx_(zem))) / (*w) / vc +
+#ifdef FAST_INTERPOLATION
+         fast_alt_rpol(fast_p_bend_ray_time0,*zem);
+#else
          rpol(p_alt,p_bend_ray_time0,num_prof,*zem);
+#endif
       return;
    }
    if ( sin_t_em > 1. || (*w) <= 0. )
@@ -709,10 +1089,16 @@ printf(" raybnd: theta = %5.3f, %5.3f\n",(double)(theta_em*180./M_PI),
    c = cos(theta_em+0.28*(theta_obs-theta_em));
    s = sin(theta_em+0.28*(theta_obs-theta_em));
    
+#ifdef FAST_INTERPOLATION
+   h = fast_alt_rpol(fast_p_bend_ray_hori_a,*zem);
+   hori_off = -(h*h) * s/(c*c*c);
+   t = fast_alt_rpol(fast_p_bend_ray_time_a,*zem);
+#else
    rho = rhofx_(zem);
    h = rpol(p_rho,p_bend_ray_hori_a,num_prof,rho);
    hori_off = -(h*h) * s/(c*c*c);
    t = rpol(p_rho,p_bend_ray_time_a,num_prof,rho);
+#endif
 #ifdef TEST_RAYBND
 printf(" raybnd: horizontal displacement = %5.2f\n",hori_off);
 printf(" raybdn: time = %5.3f + %5.3f +%5.3f + %5.3f\n",
@@ -721,8 +1107,13 @@ printf(" raybdn: time = %5.3f + %5.3f +%5.3f + %5.3f\n",
    rpol(p_alt,p_bend_ray_time0,num_prof,*zem),
       -(t*t) * (s*s)/(c*c*c));
 #endif
+#ifdef FAST_INTERPOLATION
+   travel_time = fast_alt_rpol(fast_p_bend_ray_time0,*zem) -
+      (t*t) * (s*s)/(c*c*c);
+#else
    travel_time = rpol(p_alt,p_bend_ray_time0,num_prof,*zem) -
       (t*t) * (s*s)/(c*c*c);
+#endif
    travel_time += (((*zem) - observation_level) + 
          etadsn*(obs_level_thick-thickx_(zem))) / (*w) / vc;
    
@@ -0,0 +1,581 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+
+    corsikaIObenchmark: end-to-end benchmarks of corsikaIOreader
+
+    Runs corsikaIOreader on one input file for a list of scenarios
+    (each in a separate process) and reports wall and cpu time, input
+    bytes/s, bunches/s, photons/s and peak resident memory as JSON.
+
+    Scenarios:
+      decode         read all blocks and photon bunches (VEventReader, no photon loop)
+      photons        photon loop without output
+      histo          -histo
+      grisu_file     -grisu FILE
+      grisu_stdout   -grisu stdout (output discarded)
+      tel2           -tel -2 (one grisu file per telescope)
+      atm_MODEL      photon loop with atmospheric extinction model MODEL
+                     (noExtinction, corsika, kascade, us76_new, us76.23km;
+                      skipped if the extinction file is not in ./data)
+      xyz            -xyz
+
+    Without input file, a file is generated with corsikaIOgenerator.
+
+    Throughput targets (optional, -targets FILE; only lines starting with '*' are read):
+
+    \code
+    * TARGET SCENARIO METRIC MINIMUM
+    \endcode
+
+    with METRIC one of bytes_per_s, bunches_per_s, photons_per_s. The
+    program returns a non-zero exit code if a target is missed.
+
+    options: try corsikaIObenchmark -help
+
+*/
+
+#include "VEventReader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct sBenchmarkScenario
+{
+    string name;
+    vector< string > arguments;        // corsikaIOreader arguments (without input file)
+    string requiredFile;               // scenario is skipped if this file does not exist
+    string status;
+    double wall_s;
+    double user_s;
+    double sys_s;
+    long   peak_rss_kb;
+};
+
+struct sBenchmarkTarget
+{
+    string scenario;
+    string metric;
+    double minimum;
+};
+
+double getTime()
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.e-6 * tv.tv_usec;
+}
+
+bool fileExists( string iFile )
+{
+    struct stat st;
+    return ( stat( iFile.c_str(), &st ) == 0 );
+}
+
+long getFileSize( string iFile )
+{
+    struct stat st;
+    if( stat( iFile.c_str(), &st ) != 0 )
+    {
+        return 0;
+    }
+    return ( long )st.st_size;
+}
+
+/*!
+    read all photon bunches of a file (decode only)
+*/
+void decodeFile( string iFile, long long& nbunches, double& nphotons, int& nevents )
+{
+    nbunches = 0;
+    nphotons = 0.;
+    nevents = 0;
+    VEventReader fReader;
+    if( !fReader.open( iFile ) )
+    {
+        exit( EXIT_FAILURE );
+    }
+    int i_block = 0;
+    while( ( i_block = fReader.next() ) >= 0 )
+    {
+        if( i_block == IO_TYPE_MC_TELARRAY && fReader.beginArray() )
+        {
+            int i_tel = 0;
+            while( ( i_tel = fReader.nextTelescope() ) != 0 )
+            {
+                if( i_tel < 0 )
+                {
+                    continue;
+                }
+                bunch* b = fReader.getBunches();
+                for( int i = 0; i < fReader.getNBunches(); i++ )
+                {
+                    nphotons += b[i].photons;
+                }
+                nbunches += fReader.getNBunches();
+            }
+            fReader.endArray();
+        }
+    }
+    nevents = fReader.getNEvents();
+    fReader.close();
+}
+
+/*!
+    run a command in a child process (stdout/stderr to /dev/null); fills time and resource usage
+*/
+bool runCommand( vector< string > iCommand, sBenchmarkScenario& s )
+{
+    vector< char* > argv;
+    for( unsigned int i = 0; i < iCommand.size(); i++ )
+    {
+        argv.push_back( const_cast< char* >( iCommand[i].c_str() ) );
+    }
+    argv.push_back( 0 );
+
+    double t_start = getTime();
+    pid_t pid = fork();
+    if( pid < 0 )
+    {
+        perror( "fork" );
+        return false;
+    }
+    if( pid == 0 )
+    {
+        int null = open( "/dev/null", O_WRONLY );
+        if( null >= 0 )
+        {
+            dup2( null, 1 );
+            dup2( null, 2 );
+        }
+        execv( argv[0], &argv[0] );
+        _exit( 127 );
+    }
+    int i_status = 0;
+    struct rusage ru;
+    if( wait4( pid, &i_status, 0, &ru ) < 0 )
+    {
+        perror( "wait4" );
+        return false;
+    }
+    s.wall_s = getTime() - t_start;
+    s.user_s = ru.ru_utime.tv_sec + 1.e-6 * ru.ru_utime.tv_usec;
+    s.sys_s = ru.ru_stime.tv_sec + 1.e-6 * ru.ru_stime.tv_usec;
+#ifdef __APPLE__
+    s.peak_rss_kb = ru.ru_maxrss / 1024;       // bytes on OS X
+#else
+    s.peak_rss_kb = ru.ru_maxrss;
+#endif
+    return ( WIFEXITED( i_status ) && WEXITSTATUS( i_status ) == 0 );
+}
+
+vector< sBenchmarkTarget > readTargets( string iFile )
+{
+    vector< sBenchmarkTarget > t;
+    ifstream is( iFile.c_str() );
+    if( !is )
+    {
+        cout << "error opening benchmark target file " << iFile << endl;
+        exit( EXIT_FAILURE );
+    }
+    string is_line;
+    string iTemp;
+    while( getline( is, is_line ) )
+    {
+        istringstream is_stream( is_line );
+        if( !( is_stream >> iTemp ) || iTemp != "*" )
+        {
+            continue;
+        }
+        if( !( is_stream >> iTemp ) || iTemp != "TARGET" )
+        {
+            continue;
+        }
+        sBenchmarkTarget i_t;
+        if( is_stream >> i_t.scenario >> i_t.metric >> i_t.minimum )
+        {
+            t.push_back( i_t );
+        }
+    }
+    return t;
+}
+
+double getMetric( const sBenchmarkScenario& s, string iMetric, long iBytes, long long iBunches, double iPhotons )
+{
+    if( s.wall_s <= 0. )
+    {
+        return 0.;
+    }
+    if( iMetric == "bytes_per_s" )
+    {
+        return iBytes / s.wall_s;
+    }
+    if( iMetric == "bunches_per_s" )
+    {
+        return iBunches / s.wall_s;
+    }
+    if( iMetric == "photons_per_s" )
+    {
+        return iPhotons / s.wall_s;
+    }
+    return 0.;
+}
+
+int main( int argc, char** argv )
+{
+    string fInputFile = "";
+    string fReader = "./corsikaIOreader";
+    string fGenerator = "./corsikaIOgenerator";
+    string fOutputFile = "";
+    string fWorkDir = "benchmark_output";
+    string fScenarioList = "";
+    string fTargetFile = "";
+    string fGeneratorOptions = "-nevents 20 -ntel 4 -narray 2 -nbunches 20000 -seed 1";
+    int fRepeat = 1;
+
+    // decode-only mode (child process of the decode scenario)
+    if( argc == 3 && string( argv[1] ) == "-decode" )
+    {
+        long long nbunches = 0;
+        double nphotons = 0.;
+        int nevents = 0;
+        decodeFile( argv[2], nbunches, nphotons, nevents );
+        cout << nevents << " events, " << nbunches << " bunches, " << nphotons << " photons" << endl;
+        return 0;
+    }
+
+    // reading of command line arguments
+    int i = 0;
+    while( i++ < argc )
+    {
+        string iTemp = argv[i - 1];
+        string iTemp2 = "";
+        if( i < argc )
+        {
+            iTemp2 = argv[i];
+        }
+        if( iTemp.find( "-help" ) < iTemp.size() )
+        {
+            cout << endl;
+            cout << "corsikaIObenchmark: end-to-end benchmarks of corsikaIOreader" << endl;
+            cout << "=============================================================" << endl << endl;
+            cout << "Command line options: " << endl << endl;
+            cout << "\t -input FILE            CORSIKA eventio input file (default: generated with corsikaIOgenerator)" << endl;
+            cout << "\t -generate \"OPTIONS\"    corsikaIOgenerator options for the generated input file" << endl;
+            cout << "\t                        (default: \"" << fGeneratorOptions << "\")" << endl;
+            cout << "\t -reader PATH           corsikaIOreader executable (default: ./corsikaIOreader)" << endl;
+            cout << "\t -generator PATH        corsikaIOgenerator executable (default: ./corsikaIOgenerator)" << endl;
+            cout << "\t -scenarios LIST        comma separated list of scenarios (default: all)" << endl;
+            cout << "\t -repeat N              run each scenario N times, report the fastest run (default: 1)" << endl;
+            cout << "\t -workdir DIR           directory for output files of the reader (default: benchmark_output)" << endl;
+            cout << "\t -targets FILE          minimum throughput per scenario (lines: * TARGET SCENARIO METRIC MINIMUM)" << endl;
+            cout << "\t -output FILE           write results (JSON) into FILE (default: stdout)" << endl;
+            cout << endl;
+            exit( 0 );
+        }
+        else if( iTemp.find( "-input" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fInputFile = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-generate" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fGeneratorOptions = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-reader" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fReader = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-generator" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fGenerator = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-scenarios" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fScenarioList = "," + iTemp2 + ",";
+            i++;
+        }
+        else if( iTemp.find( "-repeat" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fRepeat = atoi( iTemp2.c_str() );
+            if( fRepeat < 1 )
+            {
+                fRepeat = 1;
+            }
+            i++;
+        }
+        else if( iTemp.find( "-workdir" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fWorkDir = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-targets" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fTargetFile = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-output" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fOutputFile = iTemp2;
+            i++;
+        }
+        else if( i > 1 )
+        {
+            cout << "unknown run parameter: " << iTemp << endl;
+            exit( -1 );
+        }
+    }
+    mkdir( fWorkDir.c_str(), 0755 );
+
+    // generate input file
+    if( fInputFile.size() == 0 )
+    {
+        fInputFile = fWorkDir + "/benchmark_input.io";
+        string iCommand = fGenerator + " -output " + fInputFile + " " + fGeneratorOptions + " > /dev/null 2>&1";
+        cerr << "generating benchmark input: " << iCommand << endl;
+        if( system( iCommand.c_str() ) != 0 )
+        {
+            cout << "error generating benchmark input file" << endl;
+            exit( EXIT_FAILURE );
+        }
+    }
+
+    // input size (bytes, bunches, photons)
+    long fBytes = getFileSize( fInputFile );
+    long long fBunches = 0;
+    double fPhotons = 0.;
+    int fEvents = 0;
+    decodeFile( fInputFile, fBunches, fPhotons, fEvents );
+
+    // list of scenarios
+    vector< sBenchmarkScenario > fScenarios;
+    sBenchmarkScenario s;
+    s.wall_s = s.user_s = s.sys_s = 0.;
+    s.peak_rss_kb = 0;
+
+    s.name = "decode";
+    s.arguments.clear();
+    fScenarios.push_back( s );
+
+    s.name = "photons";
+    fScenarios.push_back( s );
+
+    s.name = "histo";
+    s.arguments.push_back( "-histo" );
+    s.arguments.push_back( fWorkDir + "/benchmark_histo.root" );
+    fScenarios.push_back( s );
+
+    s.name = "grisu_file";
+    s.arguments.clear();
+    s.arguments.push_back( "-grisu" );
+    s.arguments.push_back( fWorkDir + "/benchmark_grisu.txt" );
+    fScenarios.push_back( s );
+
+    s.name = "grisu_stdout";
+    s.arguments.clear();
+    s.arguments.push_back( "-grisu" );
+    s.arguments.push_back( "stdout" );
+    fScenarios.push_back( s );
+
+    s.name = "tel2";
+    s.arguments.clear();
+    s.arguments.push_back( "-tel" );
+    s.arguments.push_back( "-2" );
+    s.arguments.push_back( "-grisu" );
+    s.arguments.push_back( fWorkDir + "/benchmark_tel2.txt" );
+    fScenarios.push_back( s );
+
+    // atmospheric extinction models (-abs argument and extinction file)
+    const char* i_atm[][2] = { { "noExtinction", "" }, { "corsika", "data/atmabs.dat" },
+        { "kascade", "data/kextint.dat" }, { "us76_new", "data/us76.50km.ext" },
+        { "data/us76.23km.ext", "data/us76.23km.ext" }
+    };
+    const char* i_atm_name[] = { "noExtinction", "corsika", "kascade", "us76_new", "us76.23km" };
+    for( unsigned int a = 0; a < sizeof( i_atm_name ) / sizeof( char* ); a++ )
+    {
+        s.name = string( "atm_" ) + i_atm_name[a];
+        s.arguments.clear();
+        s.arguments.push_back( "-abs" );
+        s.arguments.push_back( i_atm[a][0] );
+        s.requiredFile = i_atm[a][1];
+        fScenarios.push_back( s );
+    }
+    s.requiredFile = "";
+
+    s.name = "xyz";
+    s.arguments.clear();
+    s.arguments.push_back( "-xyz" );
+    s.arguments.push_back( fWorkDir + "/benchmark_xyz.root" );
+    fScenarios.push_back( s );
+
+    // run all scenarios
+    for( unsigned int n = 0; n < fScenarios.size(); n++ )
+    {
+        if( fScenarioList.size() > 0 && fScenarioList.find( "," + fScenarios[n].name + "," ) == string::npos )
+        {
+            fScenarios[n].status = "not_selected";
+            continue;
+        }
+        if( fScenarios[n].requiredFile.size() > 0 && !fileExists( fScenarios[n].requiredFile ) )
+        {
+            fScenarios[n].status = "skipped";
+            continue;
+        }
+        vector< string > iCommand;
+        if( fScenarios[n].name == "decode" )
+        {
+            iCommand.push_back( argv[0] );
+            iCommand.push_back( "-decode" );
+            iCommand.push_back( fInputFile );
+        }
+        else
+        {
+            iCommand.push_back( fReader );
+            iCommand.push_back( "-cors" );
+            iCommand.push_back( fInputFile );
+            iCommand.push_back( "-seed" );
+            iCommand.push_back( "1" );
+            iCommand.insert( iCommand.end(), fScenarios[n].arguments.begin(), fScenarios[n].arguments.end() );
+        }
+        cerr << "running scenario " << fScenarios[n].name << endl;
+        fScenarios[n].status = "ok";
+        for( int r = 0; r < fRepeat; r++ )
+        {
+            sBenchmarkScenario i_run = fScenarios[n];
+            if( !runCommand( iCommand, i_run ) )
+            {
+                fScenarios[n].status = "failed";
+                break;
+            }
+            if( r == 0 || i_run.wall_s < fScenarios[n].wall_s )
+            {
+                fScenarios[n].wall_s = i_run.wall_s;
+                fScenarios[n].user_s = i_run.user_s;
+                fScenarios[n].sys_s = i_run.sys_s;
+            }
+            if( i_run.peak_rss_kb > fScenarios[n].peak_rss_kb )
+            {
+                fScenarios[n].peak_rss_kb = i_run.peak_rss_kb;
+            }
+        }
+    }
+
+    // throughput targets
+    vector< sBenchmarkTarget > fTargets;
+    if( fTargetFile.size() > 0 )
+    {
+        fTargets = readTargets( fTargetFile );
+    }
+    bool bTargetsMet = true;
+
+    // results (JSON)
+    ostringstream os;
+    os.precision( 6 );
+    os << "{" << endl;
+    os << "  \"input\": \"" << fInputFile << "\"," << endl;
+    os << "  \"events\": " << fEvents << "," << endl;
+    os << "  \"bytes\": " << fBytes << "," << endl;
+    os << "  \"bunches\": " << fBunches << "," << endl;
+    os << "  \"photons\": " << fixed << setprecision( 1 ) << fPhotons << "," << endl;
+    os.unsetf( ios::fixed );
+    os.precision( 6 );
+    os << "  \"repeat\": " << fRepeat << "," << endl;
+    os << "  \"scenarios\": [" << endl;
+    bool bFirst = true;
+    for( unsigned int n = 0; n < fScenarios.size(); n++ )
+    {
+        const sBenchmarkScenario& r = fScenarios[n];
+        if( r.status == "not_selected" )
+        {
+            continue;
+        }
+        if( !bFirst )
+        {
+            os << "," << endl;
+        }
+        bFirst = false;
+        os << "    { \"name\": \"" << r.name << "\", \"status\": \"" << r.status << "\"";
+        if( r.status == "ok" )
+        {
+            os << ", \"wall_s\": " << r.wall_s;
+            os << ", \"user_s\": " << r.user_s;
+            os << ", \"sys_s\": " << r.sys_s;
+            os << ", \"bytes_per_s\": " << getMetric( r, "bytes_per_s", fBytes, fBunches, fPhotons );
+            os << ", \"bunches_per_s\": " << getMetric( r, "bunches_per_s", fBytes, fBunches, fPhotons );
+            os << ", \"photons_per_s\": " << getMetric( r, "photons_per_s", fBytes, fBunches, fPhotons );
+            os << ", \"peak_rss_kb\": " << r.peak_rss_kb;
+        }
+        for( unsigned int t = 0; t < fTargets.size(); t++ )
+        {
+            if( fTargets[t].scenario != r.name )
+            {
+                continue;
+            }
+            bool bMet = ( r.status == "ok" && getMetric( r, fTargets[t].metric, fBytes, fBunches, fPhotons ) >= fTargets[t].minimum );
+            os << ", \"target_" << fTargets[t].metric << "\": " << fTargets[t].minimum;
+            os << ", \"target_" << fTargets[t].metric << "_met\": " << ( bMet ? "true" : "false" );
+            if( !bMet )
+            {
+                bTargetsMet = false;
+            }
+        }
+        os << " }";
+    }
+    os << endl << "  ]" << endl;
+    os << "}" << endl;
+
+    if( fOutputFile.size() > 0 )
+    {
+        ofstream of( fOutputFile.c_str() );
+        of << os.str();
+        of.close();
+        cerr << "benchmark results written to " << fOutputFile << endl;
+    }
+    else
+    {
+        cout << os.str();
+    }
+
+    if( !bTargetsMet )
+    {
+        cerr << "benchmark: throughput target(s) missed" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,488 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+
+    corsikaIOgenerator: write synthetic CORSIKA eventio files (IACT format)
+
+    Produces reproducible input files of any size for benchmarking and
+    testing of corsikaIOreader on machines without CORSIKA. The files
+    contain the same blocks as written by the CORSIKA IACT package
+    (run header, telescope positions, event header, array offsets,
+    photon bunches per telescope, event and run trailer).
+
+    Photon bunches (simple model of a Cherenkov light pool):
+      - number of bunches per telescope: Poisson distributed with mean
+        NBUNCH (flat light pool up to 120 m from the core, exponential
+        decrease with 80 m scale length beyond)
+      - directions: shower direction with Gaussian spread of 1 deg
+      - arrival times: Gaussian spread of 2 ns plus 1 ns per 100 m core distance
+      - emission heights: Gaussian, 10 +- 3 km above the observation level
+      - positions: uniform within the telescope sphere
+
+    options: try corsikaIOgenerator -help
+
+*/
+
+#include "initial.h"
+#include "io_basic.h"
+#include "mc_tel.h"
+#include "sim_cors.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*!
+    number of photons in a bunch (all bunches at most 327 photons for compact format)
+*/
+double getBunchSize( mt19937& iRandom, string iDistribution, double iBunchSize, bool bCompact )
+{
+    double ph = iBunchSize;
+    if( iDistribution == "uniform" )
+    {
+        ph = iBunchSize * ( 1. - uniform_real_distribution< double >( 0., 1. )( iRandom ) );
+    }
+    else if( iDistribution == "exponential" )
+    {
+        ph = exponential_distribution< double >( 1. / iBunchSize )( iRandom );
+    }
+    if( ph <= 0. )
+    {
+        ph = 0.01;
+    }
+    if( bCompact && ph > 327. )
+    {
+        ph = 327.;
+    }
+    return ph;
+}
+
+int main( int argc, char** argv )
+{
+    string fOutputFile = "";
+    int nevents = 10;                 // number of showers
+    int ntel = 4;                     // number of telescopes
+    double fTelSpacing = 100.;        // distance between telescopes on a square grid [m]
+    double fTelRadius = 1.5;          // radius of telescope spheres [m]
+    int narray = 1;                   // number of arrays per shower (core reuse)
+    double fCoreRadius = 200.;        // maximum core distance [m]
+    double fNBunches = 10000.;        // mean number of bunches per telescope
+    double fBunchSize = 5.;           // CORSIKA bunch size (CERSIZ)
+    string fBunchSizeDistribution = "fixed";
+    bool bCompact = false;            // compact bunch format
+    string fWavelength = "zero";      // wavelength mode
+    double fWavelengthMin = 300.;     // [nm]
+    double fWavelengthMax = 700.;
+    double fEnergy = 1.;              // [TeV]
+    int fParticle = 1;                // CORSIKA particle ID
+    double fZenith = 20.;             // [deg]
+    double fAzimuth = 0.;             // [deg]
+    double fObsLevel = 2200.;         // [m]
+    int fAtmosphere = 61;             // atmospheric profile (CHERENKOV OPTIONS; data/atmprof61.dat)
+    int fRun = 1;
+    int fSeed = 0;
+
+    // reading of command line arguments
+    int i = 0;
+    while( i++ < argc )
+    {
+        string iTemp = argv[i - 1];
+        string iTemp2 = "";
+        if( i < argc )
+        {
+            iTemp2 = argv[i];
+        }
+        if( argc == 1 || iTemp.find( "-help" ) < iTemp.size() )
+        {
+            cout << endl;
+            cout << "corsikaIOgenerator: write synthetic CORSIKA eventio files" << endl;
+            cout << "=========================================================" << endl << endl;
+            cout << "Command line options: " << endl << endl;
+            cout << "\t -output FILENAME         eventio output file" << endl;
+            cout << "\t -nevents INT             number of showers (default: 10)" << endl;
+            cout << "\t -ntel INT                number of telescopes on a square grid (default: 4)" << endl;
+            cout << "\t -telspacing FLOAT        distance between telescopes [m] (default: 100)" << endl;
+            cout << "\t -telradius FLOAT         radius of telescope spheres [m] (default: 1.5)" << endl;
+            cout << "\t -narray INT              number of arrays (core positions) per shower (default: 1)" << endl;
+            cout << "\t -coreradius FLOAT        maximum core distance [m] (default: 200)" << endl;
+            cout << "\t -nbunches FLOAT          mean number of bunches per telescope in the light pool (default: 10000)" << endl;
+            cout << "\t -bunchsize FLOAT         CORSIKA bunch size (default: 5)" << endl;
+            cout << "\t -bunchsizedist DIST      distribution of bunch sizes: fixed, uniform (0,SIZE], exponential (default: fixed)" << endl;
+            cout << "\t -compact                 write compact bunches (bunch size <= 327)" << endl;
+            cout << "\t -wavelength MODE         zero (wavelengths generated by the reader), corsika (1/lambda^2 distribution)," << endl;
+            cout << "\t                          ceffic (-1, efficiencies applied in CORSIKA) (default: zero)" << endl;
+            cout << "\t -wavelengthlimits MIN MAX  Cherenkov wavelength range [nm] (default: 300 700)" << endl;
+            cout << "\t -energy FLOAT            primary energy [TeV] (default: 1)" << endl;
+            cout << "\t -primary INT             CORSIKA particle ID (default: 1, gamma)" << endl;
+            cout << "\t -zenith FLOAT            zenith angle [deg] (default: 20)" << endl;
+            cout << "\t -azimuth FLOAT           azimuth angle [deg] (default: 0)" << endl;
+            cout << "\t -obslevel FLOAT          observation level [m] (default: 2200)" << endl;
+            cout << "\t -atmosphere INT          atmospheric profile ID (default: 61)" << endl;
+            cout << "\t -run INT                 run number (default: 1)" << endl;
+            cout << "\t -seed INT                seed for random generator (default: 0)" << endl;
+            cout << endl;
+            exit( 0 );
+        }
+        else if( iTemp.find( "-output" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fOutputFile = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-nevents" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            nevents = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-ntel" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            ntel = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-telspacing" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fTelSpacing = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-telradius" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fTelRadius = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-narray" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            narray = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-coreradius" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fCoreRadius = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-nbunches" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fNBunches = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-bunchsizedist" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fBunchSizeDistribution = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-bunchsize" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fBunchSize = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-compact" ) < iTemp.size() )
+        {
+            bCompact = true;
+        }
+        else if( iTemp.find( "-wavelengthlimits" ) < iTemp.size() && iTemp2.size() > 0 && i + 1 < argc )
+        {
+            fWavelengthMin = atof( iTemp2.c_str() );
+            fWavelengthMax = atof( argv[i + 1] );
+            i += 2;
+        }
+        else if( iTemp.find( "-wavelength" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fWavelength = iTemp2;
+            i++;
+        }
+        else if( iTemp.find( "-energy" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fEnergy = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-primary" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fParticle = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-zenith" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fZenith = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-azimuth" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fAzimuth = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-obslevel" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fObsLevel = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-atmosphere" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fAtmosphere = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-run" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fRun = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-seed" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fSeed = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( i > 1 )
+        {
+            cout << "unknown run parameter: " << iTemp << endl;
+            exit( -1 );
+        }
+    }
+    if( fOutputFile.size() == 0 )
+    {
+        cout << "error: no output file given (use -output FILENAME)" << endl;
+        exit( -1 );
+    }
+    if( ntel < 1 || ntel > MAX_TEL )
+    {
+        cout << "error: number of telescopes out of range (1 - " << MAX_TEL << ")" << endl;
+        exit( -1 );
+    }
+    if( narray < 1 || narray > MAX_ARRAY )
+    {
+        cout << "error: number of arrays out of range (1 - " << MAX_ARRAY << ")" << endl;
+        exit( -1 );
+    }
+    if( fBunchSizeDistribution != "fixed" && fBunchSizeDistribution != "uniform" && fBunchSizeDistribution != "exponential" )
+    {
+        cout << "error: unknown bunch size distribution: " << fBunchSizeDistribution << endl;
+        exit( -1 );
+    }
+    if( fWavelength != "zero" && fWavelength != "corsika" && fWavelength != "ceffic" )
+    {
+        cout << "error: unknown wavelength mode: " << fWavelength << endl;
+        exit( -1 );
+    }
+    if( bCompact && fBunchSize > 327. )
+    {
+        cout << "error: bunch size too large for compact bunches (<= 327)" << endl;
+        exit( -1 );
+    }
+
+    // random generator (identical files for identical seeds)
+    mt19937 fRandom( fSeed );
+    uniform_real_distribution< double > fUniform( 0., 1. );
+    normal_distribution< double > fGaus( 0., 1. );
+
+    IO_BUFFER* iobuf = allocate_io_buffer( 0 );
+    if( iobuf == NULL )
+    {
+        fprintf( stderr, "Output I/O buffer not allocated\n" );
+        exit( 1 );
+    }
+    iobuf->max_length = 1000000000L;
+    if( ( iobuf->output_file = fopen( fOutputFile.c_str(), "w" ) ) == NULL )
+    {
+        perror( fOutputFile.c_str() );
+        exit( 1 );
+    }
+
+    const double degrad = M_PI / 180.;
+    real h[273];
+
+    // run header
+    for( int j = 0; j < 273; j++ )
+    {
+        h[j] = 0.;
+    }
+    h[1] = fRun;
+    h[2] = 260101;                    // production date
+    h[3] = 7.7410;                    // CORSIKA version
+    h[4] = 1;                         // number of observation levels
+    h[5] = fObsLevel * 100.;          // [cm]
+    h[15] = -2.;                      // energy spectrum slope
+    h[16] = fEnergy * 1.e3;           // energy range [GeV]
+    h[17] = fEnergy * 1.e3;
+    write_tel_block( iobuf, IO_TYPE_MC_RUNH, fRun, h, 273 );
+
+    // telescope positions (square grid) [cm]
+    vector< double > xtel( ntel, 0. );
+    vector< double > ytel( ntel, 0. );
+    vector< double > ztel( ntel, 500. );
+    vector< double > rtel( ntel, fTelRadius * 100. );
+    int ngrid = ( int )ceil( sqrt( ( double )ntel ) );
+    for( int t = 0; t < ntel; t++ )
+    {
+        xtel[t] = ( ( t % ngrid ) - 0.5 * ( ngrid - 1 ) ) * fTelSpacing * 100.;
+        ytel[t] = ( ( t / ngrid ) - 0.5 * ( ngrid - 1 ) ) * fTelSpacing * 100.;
+    }
+    write_tel_pos( iobuf, ntel, &xtel[0], &ytel[0], &ztel[0], &rtel[0] );
+
+    // direction cosines of the shower (CORSIKA convention: direction of motion, z downwards)
+    double cx0 = sin( fZenith * degrad ) * cos( fAzimuth * degrad );
+    double cy0 = sin( fZenith * degrad ) * sin( fAzimuth * degrad );
+
+    vector< struct bunch > bunches;
+    vector< struct compact_bunch > cbunches;
+    vector< double > xoff( narray, 0. );
+    vector< double > yoff( narray, 0. );
+    long long nbunches_total = 0;
+    double nphotons_total = 0.;
+
+    for( int e = 0; e < nevents; e++ )
+    {
+        // event header
+        for( int j = 0; j < 273; j++ )
+        {
+            h[j] = 0.;
+        }
+        h[1] = e + 1;                 // event number
+        h[2] = fParticle;
+        h[3] = fEnergy * 1.e3;        // [GeV]
+        h[6] = 2.5e6;                 // height of first interaction [cm]
+        h[10] = fZenith * degrad;
+        h[11] = fAzimuth * degrad;
+        h[43] = fRun;
+        h[44] = 260101;
+        h[46] = 1;
+        h[47] = fObsLevel * 100.;
+        h[76] = ( float )( ( fAtmosphere << 10 ) | 3 );   // CHERENKOV OPTIONS (atmosphere, IACT)
+        if( fWavelength == "ceffic" )
+        {
+            h[76] += 4;                                  // CEFFIC
+        }
+        h[80] = h[81] = fZenith;
+        h[82] = h[83] = fAzimuth;
+        h[84] = fBunchSize;
+        h[95] = fWavelengthMin;
+        h[96] = fWavelengthMax;
+        h[97] = narray;
+        write_tel_block( iobuf, IO_TYPE_MC_EVTH, e + 1, h, 273 );
+
+        // core positions (uniform in a circle) [cm]
+        for( int a = 0; a < narray; a++ )
+        {
+            double r = fCoreRadius * 100. * sqrt( fUniform( fRandom ) );
+            double phi = 2. * M_PI * fUniform( fRandom );
+            xoff[a] = r * cos( phi );
+            yoff[a] = r * sin( phi );
+        }
+        write_tel_offset( iobuf, narray, 0., &xoff[0], &yoff[0] );
+
+        for( int a = 0; a < narray; a++ )
+        {
+            IO_ITEM_HEADER item_header;
+            begin_write_tel_array( iobuf, &item_header, a );
+            for( int t = 0; t < ntel; t++ )
+            {
+                // distance of telescope to the shower core (xcore = -xoff) [m]
+                double dx = ( xtel[t] + xoff[a] ) * 0.01;
+                double dy = ( ytel[t] + yoff[a] ) * 0.01;
+                double rcore = sqrt( dx * dx + dy * dy );
+                double mean = fNBunches;
+                if( rcore > 120. )
+                {
+                    mean *= exp( -( rcore - 120. ) / 80. );
+                }
+                int nb = ( mean > 0. ? poisson_distribution< int >( mean )( fRandom ) : 0 );
+                bunches.resize( nb );
+                double photons = 0.;
+                for( int b = 0; b < nb; b++ )
+                {
+                    double r = rtel[t] * sqrt( fUniform( fRandom ) );
+                    double phi = 2. * M_PI * fUniform( fRandom );
+                    bunches[b].photons = getBunchSize( fRandom, fBunchSizeDistribution, fBunchSize, bCompact );
+                    bunches[b].x = r * cos( phi );
+                    bunches[b].y = r * sin( phi );
+                    bunches[b].cx = cx0 + degrad * fGaus( fRandom );
+                    bunches[b].cy = cy0 + degrad * fGaus( fRandom );
+                    bunches[b].ctime = rcore * 0.01 + 2. * fGaus( fRandom );
+                    bunches[b].zem = fObsLevel * 100. + fabs( 1.e6 + 3.e5 * fGaus( fRandom ) );
+                    if( fWavelength == "corsika" )
+                    {
+                        bunches[b].lambda = 1. / ( 1. / fWavelengthMin - fUniform( fRandom ) * ( 1. / fWavelengthMin - 1. / fWavelengthMax ) );
+                    }
+                    else if( fWavelength == "ceffic" )
+                    {
+                        bunches[b].lambda = -1.;
+                    }
+                    else
+                    {
+                        bunches[b].lambda = 0.;
+                    }
+                    photons += bunches[b].photons;
+                }
+                if( bCompact )
+                {
+                    cbunches.resize( nb );
+                    for( int b = 0; b < nb; b++ )
+                    {
+                        cbunches[b].photons = ( short )Nint( bunches[b].photons * 100. );
+                        cbunches[b].x = ( short )Nint( bunches[b].x * 10. );
+                        cbunches[b].y = ( short )Nint( bunches[b].y * 10. );
+                        cbunches[b].cx = ( short )Nint( bunches[b].cx * 30000. );
+                        cbunches[b].cy = ( short )Nint( bunches[b].cy * 30000. );
+                        cbunches[b].ctime = ( short )Nint( bunches[b].ctime * 10. );
+                        cbunches[b].log_zem = ( short )Nint( log10( bunches[b].zem ) * 1000. );
+                        cbunches[b].lambda = ( short )Nint( bunches[b].lambda );
+                    }
+                    write_tel_compact_photons( iobuf, a, t, photons, ( nb > 0 ? &cbunches[0] : NULL ), nb, 0, NULL );
+                }
+                else
+                {
+                    write_tel_photons( iobuf, a, t, photons, ( nb > 0 ? &bunches[0] : NULL ), nb, 0, NULL );
+                }
+                nbunches_total += nb;
+                nphotons_total += photons;
+            }
+            end_write_tel_array( iobuf, &item_header );
+        }
+
+        // event trailer
+        for( int j = 0; j < 273; j++ )
+        {
+            h[j] = 0.;
+        }
+        h[1] = e + 1;
+        write_tel_block( iobuf, IO_TYPE_MC_EVTE, e + 1, h, 273 );
+    }
+
+    // run trailer
+    for( int j = 0; j < 273; j++ )
+    {
+        h[j] = 0.;
+    }
+    h[1] = fRun;
+    h[2] = nevents;
+    write_tel_block( iobuf, IO_TYPE_MC_RUNE, fRun, h, 273 );
+
+    long fBytes = ftell( iobuf->output_file );
+    fclose( iobuf->output_file );
+    iobuf->output_file = NULL;
+    free_io_buffer( iobuf );
+
+    cout << "corsikaIOgenerator: " << fOutputFile << endl;
+    cout << "\t showers: " << nevents << ", arrays per shower: " << narray << ", telescopes: " << ntel << endl;
+    cout << "\t bunches: " << nbunches_total << ", photons: " << nphotons_total;
+    cout << ( bCompact ? " (compact bunches)" : "" ) << endl;
+    cout << "\t file size: " << fBytes << " bytes" << endl;
+
+    return 0;
+}
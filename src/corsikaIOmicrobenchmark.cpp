@@ -0,0 +1,557 @@
+/*
+=============================================================================
+    corsikaIOreader is a tool to read CORSIKA eventio files
+    Copyright (C) 2004, 2013, 2019 Gernot Maier and Henrike Fleischhack
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+=============================================================================
+
+    corsikaIOmicrobenchmark: microbenchmarks of the eventio decoding layer
+
+    Times the eventio primitives (get_short, get_real, get_long,
+    get_count, get_vector_of_*), the block synchronisation in
+    find_io_block, search_sub_item and read_tel_photons (long and
+    compact bunches), each for native and swapped byte order.
+
+    Data are written with the corresponding put_ / write_tel_ functions
+    (byte order as set in the I/O buffer) before the timing. Each
+    benchmark is repeated until the minimum time (-mintime) is reached.
+    Results (ns per operation, MB/s of decoded data) are printed as JSON
+    (MB/s is null for benchmarks without decoded data).
+
+    options: try corsikaIOmicrobenchmark -help
+
+*/
+
+#include "initial.h"
+#include "io_basic.h"
+#include "mc_tel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// result of one microbenchmark
+struct sMicroBenchmark
+{
+    string name;
+    string byteOrder;
+    double ops;                        // number of decoded values / blocks / bunches
+    double bytes;                      // number of decoded bytes
+    double seconds;
+};
+
+double getTime()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+}
+
+// result sink (prevents elimination of the decoding loops)
+volatile double fSink = 0.;
+
+/*
+    direct access to the I/O buffer memory (no item structure) for the primitives
+*/
+void beginWrite( IO_BUFFER* iobuf, int iByteOrder )
+{
+    iobuf->data = iobuf->buffer;
+    iobuf->w_remaining = iobuf->buflen;
+    iobuf->byte_order = iByteOrder;
+}
+
+void beginRead( IO_BUFFER* iobuf, long iLength, int iByteOrder )
+{
+    iobuf->data = iobuf->buffer;
+    iobuf->r_remaining = iLength;
+    iobuf->byte_order = iByteOrder;
+}
+
+/*!
+    time decoding of n values of one primitive type
+
+    \param iType  short, real, long, count, vector_of_short, vector_of_int32, vector_of_long, vector_of_real, vector_of_float
+*/
+sMicroBenchmark benchmarkPrimitive( IO_BUFFER* iobuf, string iType, int n, int iByteOrder, double iMinTime )
+{
+    const int nvec = 1000;             // length of vectors
+    vector< short > vs( nvec );
+    vector< int32_t > vi( nvec );
+    vector< long > vl( nvec );
+    vector< double > vd( nvec );
+    vector< float > vf( nvec );
+
+    // fill buffer
+    srand( 1 );
+    beginWrite( iobuf, iByteOrder );
+    for( int i = 0; i < n; i++ )
+    {
+        if( iType == "short" )
+        {
+            put_short( rand() % 60000 - 30000, iobuf );
+        }
+        else if( iType == "real" )
+        {
+            put_real( 1.e3 * rand() / RAND_MAX, iobuf );
+        }
+        else if( iType == "long" )
+        {
+            put_long( rand() - RAND_MAX / 2, iobuf );
+        }
+        else if( iType == "count" )
+        {
+            // mix of 1 to 5 byte long values
+            put_count( ( uintmax_t )rand() >> ( rand() % 31 ), iobuf );
+        }
+        else if( i % nvec == 0 && i + nvec <= n )
+        {
+            for( int j = 0; j < nvec; j++ )
+            {
+                vs[j] = ( short )( rand() % 60000 - 30000 );
+                vi[j] = rand() - RAND_MAX / 2;
+                vl[j] = rand() - RAND_MAX / 2;
+                vd[j] = 1.e3 * rand() / RAND_MAX;
+                vf[j] = ( float )vd[j];
+            }
+            if( iType == "vector_of_short" )
+            {
+                put_vector_of_short( &vs[0], nvec, iobuf );
+            }
+            else if( iType == "vector_of_int32" )
+            {
+                put_vector_of_int32( &vi[0], nvec, iobuf );
+            }
+            else if( iType == "vector_of_long" )
+            {
+                put_vector_of_long( &vl[0], nvec, iobuf );
+            }
+            else if( iType == "vector_of_real" )
+            {
+                put_vector_of_real( &vd[0], nvec, iobuf );
+            }
+            else if( iType == "vector_of_float" )
+            {
+                put_vector_of_float( &vf[0], nvec, iobuf );
+            }
+        }
+    }
+    long nbytes = ( long )( iobuf->data - iobuf->buffer );
+
+    sMicroBenchmark r;
+    r.name = "get_" + iType;
+    r.byteOrder = ( iByteOrder == 0 ? "native" : "swapped" );
+    r.ops = 0.;
+    r.bytes = 0.;
+    double t_start = getTime();
+    double sum = 0.;
+    do
+    {
+        beginRead( iobuf, nbytes, iByteOrder );
+        if( iType == "short" )
+        {
+            for( int i = 0; i < n; i++ )
+            {
+                sum += get_short( iobuf );
+            }
+        }
+        else if( iType == "real" )
+        {
+            for( int i = 0; i < n; i++ )
+            {
+                sum += get_real( iobuf );
+            }
+        }
+        else if( iType == "long" )
+        {
+            for( int i = 0; i < n; i++ )
+            {
+                sum += get_long( iobuf );
+            }
+        }
+        else if( iType == "count" )
+        {
+            for( int i = 0; i < n; i++ )
+            {
+                sum += get_count( iobuf );
+            }
+        }
+        else
+        {
+            for( int i = 0; i + nvec <= n; i += nvec )
+            {
+                if( iType == "vector_of_short" )
+                {
+                    get_vector_of_short( &vs[0], nvec, iobuf );
+                    sum += vs[nvec - 1];
+                }
+                else if( iType == "vector_of_int32" )
+                {
+                    get_vector_of_int32( &vi[0], nvec, iobuf );
+                    sum += vi[nvec - 1];
+                }
+                else if( iType == "vector_of_long" )
+                {
+                    get_vector_of_long( &vl[0], nvec, iobuf );
+                    sum += vl[nvec - 1];
+                }
+                else if( iType == "vector_of_real" )
+                {
+                    get_vector_of_real( &vd[0], nvec, iobuf );
+                    sum += vd[nvec - 1];
+                }
+                else if( iType == "vector_of_float" )
+                {
+                    get_vector_of_float( &vf[0], nvec, iobuf );
+                    sum += vf[nvec - 1];
+                }
+            }
+        }
+        r.ops += ( iType.find( "vector" ) == 0 ? ( n / nvec ) * nvec : n );
+        r.bytes += nbytes;
+        r.seconds = getTime() - t_start;
+    }
+    while( r.seconds < iMinTime );
+    fSink = sum;
+    return r;
+}
+
+/*!
+    write one array block with ntel telescopes of nbunch photon bunches each
+*/
+void writeTelArray( IO_BUFFER* iobuf, int ntel, int nbunch, bool bCompact )
+{
+    vector< struct bunch > b( nbunch );
+    vector< struct compact_bunch > cb( nbunch );
+    srand( 1 );
+    for( int i = 0; i < nbunch; i++ )
+    {
+        b[i].photons = 5.;
+        b[i].x = 200. * ( rand() / ( double )RAND_MAX - 0.5 );
+        b[i].y = 200. * ( rand() / ( double )RAND_MAX - 0.5 );
+        b[i].cx = 0.2 + 0.02 * ( rand() / ( double )RAND_MAX - 0.5 );
+        b[i].cy = 0.02 * ( rand() / ( double )RAND_MAX - 0.5 );
+        b[i].ctime = 20. * rand() / ( double )RAND_MAX;
+        b[i].zem = 1.e6 + 1.e5 * rand() / ( double )RAND_MAX;
+        b[i].lambda = 0.;
+        cb[i].photons = ( short )Nint( b[i].photons * 100. );
+        cb[i].x = ( short )Nint( b[i].x * 10. );
+        cb[i].y = ( short )Nint( b[i].y * 10. );
+        cb[i].cx = ( short )Nint( b[i].cx * 30000. );
+        cb[i].cy = ( short )Nint( b[i].cy * 30000. );
+        cb[i].ctime = ( short )Nint( b[i].ctime * 10. );
+        cb[i].log_zem = ( short )Nint( log10( b[i].zem ) * 1000. );
+        cb[i].lambda = 0;
+    }
+    IO_ITEM_HEADER item_header;
+    begin_write_tel_array( iobuf, &item_header, 0 );
+    for( int t = 0; t < ntel; t++ )
+    {
+        if( bCompact )
+        {
+            write_tel_compact_photons( iobuf, 0, t, 5. * nbunch, &cb[0], nbunch, 0, NULL );
+        }
+        else
+        {
+            write_tel_photons( iobuf, 0, t, 5. * nbunch, &b[0], nbunch, 0, NULL );
+        }
+    }
+    end_write_tel_array( iobuf, &item_header );
+}
+
+/*!
+    time find_io_block / skip_io_block over a file with n small blocks
+*/
+sMicroBenchmark benchmarkFindBlock( int n, int iByteOrder, double iMinTime )
+{
+    IO_BUFFER* iobuf = allocate_io_buffer( 0 );
+    iobuf->max_length = 100000000L;
+    FILE* f = tmpfile();
+    iobuf->output_file = f;
+    iobuf->byte_order = iByteOrder;
+    real h[273];
+    for( int j = 0; j < 273; j++ )
+    {
+        h[j] = ( real )j;
+    }
+    for( int i = 0; i < n; i++ )
+    {
+        write_tel_block( iobuf, IO_TYPE_MC_EVTE, i, h, 273 );
+    }
+    fflush( f );
+    iobuf->output_file = NULL;
+    iobuf->input_file = f;
+
+    sMicroBenchmark r;
+    r.name = "find_io_block";
+    r.byteOrder = ( iByteOrder == 0 ? "native" : "swapped" );
+    r.ops = 0.;
+    r.bytes = 0.;
+    IO_ITEM_HEADER block_header;
+    double t_start = getTime();
+    do
+    {
+        rewind( f );
+        while( find_io_block( iobuf, &block_header ) == 0 )
+        {
+            if( iobuf->byte_order != iByteOrder )
+            {
+                cout << "error: wrong byte order in find_io_block benchmark" << endl;
+                exit( EXIT_FAILURE );
+            }
+            r.bytes += iobuf->item_length[0];
+            skip_io_block( iobuf, &block_header );
+            r.ops++;
+        }
+        r.seconds = getTime() - t_start;
+    }
+    while( r.seconds < iMinTime );
+    fclose( f );
+    iobuf->input_file = NULL;
+    free_io_buffer( iobuf );
+    return r;
+}
+
+/*!
+    time search_sub_item (skipping all telescopes of an array) and read_tel_photons
+*/
+vector< sMicroBenchmark > benchmarkTelPhotons( int ntel, int nbunch, bool bCompact, int iByteOrder, double iMinTime )
+{
+    IO_BUFFER* iobuf = allocate_io_buffer( 0 );
+    iobuf->max_length = 1000000000L;
+    FILE* f = tmpfile();
+    iobuf->output_file = f;
+    iobuf->byte_order = iByteOrder;
+    writeTelArray( iobuf, ntel, nbunch, bCompact );
+    fflush( f );
+    rewind( f );
+    iobuf->output_file = NULL;
+    iobuf->input_file = f;
+
+    IO_ITEM_HEADER block_header;
+    IO_ITEM_HEADER item_header;
+    IO_ITEM_HEADER sub_item_header;
+    int iarray = 0;
+    if( find_io_block( iobuf, &block_header ) != 0 || read_io_block( iobuf, &block_header ) != 0
+            || begin_read_tel_array( iobuf, &item_header, &iarray ) < 0 )
+    {
+        cout << "error: reading of array block failed" << endl;
+        exit( EXIT_FAILURE );
+    }
+    string i_format = ( bCompact ? "compact" : "long" );
+    long nbytes = iobuf->item_length[0];
+
+    vector< sMicroBenchmark > r( 2 );
+    // search for an item type not in the array (skips all telescopes; no data decoded)
+    r[0].name = "search_sub_item_" + i_format;
+    r[0].byteOrder = ( iByteOrder == 0 ? "native" : "swapped" );
+    r[0].ops = 0.;
+    r[0].bytes = 0.;
+    double t_start = getTime();
+    do
+    {
+        rewind_item( iobuf, &item_header );
+        sub_item_header.type = IO_TYPE_MC_PHOTONS + 99;
+        search_sub_item( iobuf, &item_header, &sub_item_header );
+        r[0].ops += ntel;
+        r[0].seconds = getTime() - t_start;
+    }
+    while( r[0].seconds < iMinTime );
+
+    // read all bunches
+    vector< struct bunch > b( nbunch );
+    r[1].name = "read_tel_photons_" + i_format;
+    r[1].byteOrder = r[0].byteOrder;
+    r[1].ops = 0.;
+    r[1].bytes = 0.;
+    double sum = 0.;
+    t_start = getTime();
+    do
+    {
+        rewind_item( iobuf, &item_header );
+        for( int t = 0; t < ntel; t++ )
+        {
+            sub_item_header.type = IO_TYPE_MC_PHOTONS;
+            if( search_sub_item( iobuf, &item_header, &sub_item_header ) < 0 )
+            {
+                break;
+            }
+            int jarray = 0;
+            int itel = 0;
+            int nb = 0;
+            double photons = 0.;
+            if( read_tel_photons( iobuf, nbunch, &jarray, &itel, &photons, &b[0], &nb ) < 0 || nb != nbunch )
+            {
+                cout << "error: reading of photon bunches failed" << endl;
+                exit( EXIT_FAILURE );
+            }
+            sum += b[nb - 1].x;
+            r[1].ops += nb;
+        }
+        r[1].bytes += nbytes;
+        r[1].seconds = getTime() - t_start;
+    }
+    while( r[1].seconds < iMinTime );
+    fSink = sum;
+
+    end_read_tel_array( iobuf, &item_header );
+    fclose( f );
+    iobuf->input_file = NULL;
+    free_io_buffer( iobuf );
+    return r;
+}
+
+int main( int argc, char** argv )
+{
+    int nvalues = 1000000;            // number of values per primitive benchmark
+    int nblocks = 10000;              // number of blocks for find_io_block
+    int ntel = 20;                    // telescopes per array
+    int nbunch = 10000;               // bunches per telescope
+    double fMinTime = 0.2;            // minimum time per benchmark [s]
+    string fOutputFile = "";
+
+    // reading of command line arguments
+    int i = 0;
+    while( i++ < argc )
+    {
+        string iTemp = argv[i - 1];
+        string iTemp2 = "";
+        if( i < argc )
+        {
+            iTemp2 = argv[i];
+        }
+        if( iTemp.find( "-help" ) < iTemp.size() )
+        {
+            cout << endl;
+            cout << "corsikaIOmicrobenchmark: microbenchmarks of the eventio decoding layer" << endl;
+            cout << "======================================================================" << endl << endl;
+            cout << "Command line options: " << endl << endl;
+            cout << "\t -nvalues INT      number of values per primitive benchmark (default: 1000000)" << endl;
+            cout << "\t -nblocks INT      number of blocks for find_io_block (default: 10000)" << endl;
+            cout << "\t -ntel INT         telescopes per array for search_sub_item/read_tel_photons (default: 20)" << endl;
+            cout << "\t -nbunches INT     bunches per telescope (default: 10000)" << endl;
+            cout << "\t -mintime FLOAT    minimum time per benchmark [s] (default: 0.2)" << endl;
+            cout << "\t -output FILE      write results (JSON) into FILE (default: stdout)" << endl;
+            cout << endl;
+            exit( 0 );
+        }
+        else if( iTemp.find( "-nvalues" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            nvalues = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-nblocks" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            nblocks = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-ntel" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            ntel = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-nbunches" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            nbunch = atoi( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-mintime" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fMinTime = atof( iTemp2.c_str() );
+            i++;
+        }
+        else if( iTemp.find( "-output" ) < iTemp.size() && iTemp2.size() > 0 )
+        {
+            fOutputFile = iTemp2;
+            i++;
+        }
+        else if( i > 1 )
+        {
+            cout << "unknown run parameter: " << iTemp << endl;
+            exit( -1 );
+        }
+    }
+    if( nvalues < 1000 || nblocks < 1 || ntel < 1 || nbunch < 1 )
+    {
+        cout << "error: invalid benchmark size" << endl;
+        exit( -1 );
+    }
+
+    vector< sMicroBenchmark > fResults;
+    IO_BUFFER* iobuf = allocate_io_buffer( 16L * nvalues + 1024 );
+    iobuf->max_length = 16L * nvalues + 1024;
+
+    const char* i_types[] = { "short", "real", "long", "count", "vector_of_short", "vector_of_int32",
+                              "vector_of_long", "vector_of_real", "vector_of_float"
+                            };
+    for( int bo = 0; bo < 2; bo++ )
+    {
+        for( unsigned int t = 0; t < sizeof( i_types ) / sizeof( char* ); t++ )
+        {
+            fResults.push_back( benchmarkPrimitive( iobuf, i_types[t], nvalues, bo, fMinTime ) );
+        }
+        fResults.push_back( benchmarkFindBlock( nblocks, bo, fMinTime ) );
+        for( int c = 0; c < 2; c++ )
+        {
+            vector< sMicroBenchmark > r = benchmarkTelPhotons( ntel, nbunch, ( c == 1 ), bo, fMinTime );
+            fResults.insert( fResults.end(), r.begin(), r.end() );
+        }
+    }
+    free_io_buffer( iobuf );
+
+    // results (JSON)
+    ostringstream os;
+    os.precision( 6 );
+    os << "{" << endl;
+    os << "  \"benchmarks\": [" << endl;
+    for( unsigned int r = 0; r < fResults.size(); r++ )
+    {
+        os << "    { \"name\": \"" << fResults[r].name << "\", \"byte_order\": \"" << fResults[r].byteOrder << "\"";
+        os << ", \"ops\": " << fResults[r].ops;
+        os << ", \"seconds\": " << fResults[r].seconds;
+        os << ", \"ns_per_op\": " << ( fResults[r].ops > 0. ? 1.e9 * fResults[r].seconds / fResults[r].ops : 0. );
+        // (no throughput for benchmarks without decoded bytes, e.g. search_sub_item)
+        if( fResults[r].bytes > 0. && fResults[r].seconds > 0. )
+        {
+            os << ", \"MB_per_s\": " << 1.e-6 * fResults[r].bytes / fResults[r].seconds;
+        }
+        else
+        {
+            os << ", \"MB_per_s\": null";
+        }
+        os << " }" << ( r + 1 < fResults.size() ? "," : "" ) << endl;
+    }
+    os << "  ]" << endl;
+    os << "}" << endl;
+
+    if( fOutputFile.size() > 0 )
+    {
+        ofstream of( fOutputFile.c_str() );
+        of << os.str();
+        of.close();
+    }
+    else
+    {
+        cout << os.str();
+    }
+    return 0;
+}
@@ -158,6 +158,62 @@ void addpath (const char *name)
       path->path = strdup(name);
 }
 
+/**
+ *  @short Find the file which fileopen() would open for reading.
+ *  Names including (part of) a path are taken as they are, other names
+ *  are searched in the include path list. URIs and compressed files
+ *  are not resolved.
+ *
+ *  @return 0 (found, name in buffer), -1 (not found)
+*/
+
+int findpath (const char *fname, char *buffer, size_t bufsize)
+{
+   struct incpath *path = root_path;
+   struct stat st;
+   int l;
+
+   if ( fname == NULL || buffer == NULL || bufsize <= 0 )
+      return -1;
+   l = strlen(fname);
+   if ( strchr(fname,':') != NULL ||
+        (l > 3 && strcmp(fname+l-3,".gz") == 0) ||
+        (l > 4 && strcmp(fname+l-4,".bz2") == 0) ||
+        (l > 4 && strcmp(fname+l-4,".lzo") == 0) ||
+        (l > 5 && strcmp(fname+l-5,".lzma") == 0) )
+      return -1;
+
+   if ( strchr(fname,'/') != NULL )
+   {
+      if ( (size_t) l >= bufsize || stat(fname,&st) != 0 )
+         return -1;
+      strcpy(buffer,fname);
+      return 0;
+   }
+
+   /* The set of search paths might not be initialized yet */
+   if ( path == NULL )
+   {
+      initpath(NULL);
+      if ( (path = root_path) == NULL )
+      	 return -1;
+   }
+   for ( ; path != NULL; path=path->next )
+   {
+      if ( path->path == NULL )
+      	 continue;
+      if ( strlen(path->path)+strlen(fname)+1 >= bufsize )
+      	 continue;
+      if ( strcmp(path->path,".") == 0 )
+      	 strcpy(buffer,fname);
+      else
+      	 sprintf(buffer,"%s/%s",path->path,fname);
+      if ( stat(buffer,&st) == 0 )
+         return 0;
+   }
+   return -1;
+}
+
 /** Helper function for opening a compressed file through a fifo. */
 
 static FILE *cmp_popen (const char *fname, const char *mode, int compression)